@@ -4,6 +4,12 @@
 #include <string>
 #include <filesystem>
 
+// SIMD
+// SSE2 is part of x64 so it is always available in our builds. The scalar paths are kept for other targets.
+#if defined(_M_X64) || defined(__SSE2__)
+  #define DASH_TOOLS_SSE2 1
+#endif
+
 namespace dash_tools
 {
   //Directory
@@ -12,6 +18,9 @@ namespace dash_tools
   // ASSET EXTENSIONS
   constexpr std::string_view FONT_EXTENSION{ ".dash_font" };
 
+  // Records the codepoints a subset font was compiled with
+  constexpr std::string_view FONT_SUBSET_MANIFEST_EXTENSION{ ".dash_font_subset" };
+
   // EXTERNAL EXTENSIONS
   constexpr std::string_view TTF_EXTENSION{ ".ttf" };
 
@@ -34,6 +34,16 @@ namespace dash_tools
     return m_fontData.bitmapHeight;
   }
 
+  std::vector<dash_tools::FontBitmapLevel> const& Font::GetMipLevels(void) const noexcept
+  {
+    return m_fontData.mipLevels;
+  }
+
+  float Font::GetPixelRange(void) const noexcept
+  {
+    return m_fontData.pixelRange;
+  }
+
   std::optional<float> Font::GetKerning(GlyphType lhs, GlyphType rhs) const noexcept
   {
     if (m_fontData.glyphMappings.count(lhs) <= 0)
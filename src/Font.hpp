@@ -23,6 +23,12 @@ namespace dash_tools
     std::vector<BitmapPixelType> const&  GetFontBitmap    (void) const noexcept;
     uint32_t                             GetBitmapWidth   (void) const noexcept;
     uint32_t                             GetBitmapHeight  (void) const noexcept;
+
+    // Every mip level encodes GetPixelRange() texels of its own size, so the range in uv space doubles each level.
+    // Shaders sampling the mip chain must scale the range by the size of the sampled level, 
+    // e.g. find the level with textureQueryLod and use pixelRange / textureSize(atlas, level).
+    std::vector<FontBitmapLevel> const&  GetMipLevels     (void) const noexcept;
+    float                                GetPixelRange    (void) const noexcept;
     std::optional<float>                 GetKerning       (GlyphType lhs, GlyphType rhs) const noexcept;
 
   private:
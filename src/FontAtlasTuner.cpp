@@ -0,0 +1,340 @@
+#include "FontAtlasTuner.hpp"
+#include "FontMipmapper.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+#ifdef DASH_TOOLS_SSE2
+#include <xmmintrin.h>
+#endif
+
+namespace dash_tools
+{
+  /***************************************************************************/
+  /*!
+
+    \brief
+      Searches minimum scales, pixel ranges and dimension constraints for the
+      smallest atlas that fits the budget and reconstructs the glyphs with
+      an error below the budget's maximum. 
+      
+      Every candidate is packed first to find its size so only candidates 
+      within the budget are measured. Those are measured from smallest to
+      largest until one is accurate enough. If none are, the most accurate
+      candidate within the budget is picked instead. Only the test glyphs
+      are generated for each candidate, never the whole atlas.
+
+    \param glyphData
+      Edge colored glyphs to pack.
+
+    \param budget
+      Maximum bytes and reconstruction error.
+
+    \return
+      Parameters and packed glyphs of the chosen atlas, or nothing if no 
+      candidate fits the budget.
+
+  */
+  /***************************************************************************/
+  std::optional<FontAtlasTuning> FontAtlasTuner::FindParameters(std::vector<msdf_atlas::GlyphGeometry> const& glyphData, FontAtlasBudget const& budget) noexcept
+  {
+    struct Candidate
+    {
+      FontAtlasParameters parameters;
+      uint32_t bytes;
+    };
+
+    int const NUM_GLYPHS = static_cast<int>(glyphData.size());
+
+    // Packing doesn't render anything so every candidate can be sized cheaply
+    std::vector<Candidate> candidates;
+    for (double const SCALE : CANDIDATE_SCALES)
+    {
+      for (double const PIXEL_RANGE : CANDIDATE_PIXEL_RANGES)
+      {
+        for (auto const CONSTRAINT : CANDIDATE_CONSTRAINTS)
+        {
+          FontAtlasParameters const PARAMETERS{ SCALE, PIXEL_RANGE, CONSTRAINT };
+
+          std::vector<msdf_atlas::GlyphGeometry> packedGlyphData{ glyphData };
+          msdf_atlas::TightAtlasPacker atlasPacker;
+          FontCompiler::ConfigureAtlasPacker(atlasPacker, PARAMETERS);
+          if (atlasPacker.pack(packedGlyphData.data(), NUM_GLYPHS) != 0)
+            continue;
+
+          int width = 0, height = 0;
+          atlasPacker.getDimensions(width, height);
+
+          // The mip chain is stored and uploaded with the atlas so it counts towards the budget
+          uint32_t const BYTES = static_cast<uint32_t>(width * height) * BYTES_PER_CHANNEL * NUM_CHANNELS + 
+                                 FontMipmapper::GetMipChainBytes(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+
+          if (BYTES <= budget.maxBytes)
+            candidates.push_back(Candidate{ PARAMETERS, BYTES });
+        }
+      }
+    }
+
+    if (candidates.empty())
+      return {};
+
+    std::stable_sort(candidates.begin(), candidates.end(), [](Candidate const& lhs, Candidate const& rhs)
+    {
+      return lhs.bytes < rhs.bytes;
+    });
+
+    // Glyphs with an outline, spread evenly over the charset
+    std::vector<uint32_t> outlineGlyphs;
+    for (uint32_t i = 0; i < glyphData.size(); ++i)
+    {
+      if (!glyphData[i].isWhitespace())
+        outlineGlyphs.push_back(i);
+    }
+
+    std::vector<uint32_t> testGlyphs;
+    size_t const STRIDE = std::max<size_t>(1, (outlineGlyphs.size() + MAX_TEST_GLYPHS - 1) / MAX_TEST_GLYPHS);
+    for (size_t i = 0; i < outlineGlyphs.size(); i += STRIDE)
+      testGlyphs.push_back(outlineGlyphs[i]);
+
+    std::optional<FontAtlasTuning> mostAccurate{};
+    double lowestError = std::numeric_limits<double>::max();
+
+    for (Candidate const& candidate : candidates)
+    {
+      FontAtlasTuning tuning{ candidate.parameters, glyphData, 0, 0 };
+      msdf_atlas::TightAtlasPacker atlasPacker;
+      FontCompiler::ConfigureAtlasPacker(atlasPacker, candidate.parameters);
+      atlasPacker.pack(tuning.packedGlyphData.data(), NUM_GLYPHS);
+      atlasPacker.getDimensions(tuning.width, tuning.height);
+
+      double const RECONSTRUCTION_ERROR = MeasureReconstructionError(tuning.packedGlyphData, testGlyphs);
+
+      std::cout << "  Scale " << candidate.parameters.minimumScale << ", pixel range " << candidate.parameters.pixelRange << ": " 
+                << tuning.width << "x" << tuning.height << " (" << candidate.bytes << " bytes), error " << RECONSTRUCTION_ERROR << std::endl;
+
+      if (RECONSTRUCTION_ERROR <= budget.maxError)
+        return tuning;
+
+      if (RECONSTRUCTION_ERROR < lowestError)
+      {
+        lowestError = RECONSTRUCTION_ERROR;
+        mostAccurate = std::move(tuning);
+      }
+    }
+
+    std::cout << "No atlas within " << budget.maxBytes << " bytes has an error below " << budget.maxError << ", using the most accurate one" << std::endl;
+
+    return mostAccurate;
+  }
+
+  /***************************************************************************/
+  /*!
+
+    \brief
+      Generates the MTSDF of each test glyph in its packed box, renders it 
+      the way a shader would (bilinear sample, median of the color channels,
+      threshold at 0.5) at SAMPLES_PER_TEXEL samples per texel, and compares
+      the result to the glyph outline rasterized directly from its contours.
+
+    \param glyphData
+      Packed glyphs.
+
+    \param testGlyphs
+      Indices of the glyphs to reconstruct.
+
+    \return
+      Number of samples where the reconstruction and outline disagree, 
+      divided by the number of samples inside the outlines.
+
+  */
+  /***************************************************************************/
+  double FontAtlasTuner::MeasureReconstructionError(std::vector<msdf_atlas::GlyphGeometry> const& glyphData, std::vector<uint32_t> const& testGlyphs) noexcept
+  {
+    uint64_t mismatchedSamples = 0;
+    uint64_t insideSamples = 0;
+
+    // 8 bit RGBA MTSDF of the current glyph, exactly as it would be in the atlas
+    std::vector<uint8_t> glyphBitmap;
+
+    // Box texels converted to floats, 1 array per color channel
+    std::vector<float> boxTexels[3];
+
+    // A row of the box interpolated vertically at the current sample row. 
+    // Padded with 1 texel on the left and 2 on the right so 4 neighbouring texels can always be loaded.
+    std::vector<float> sampleRow[3];
+
+    msdfgen::Scanline scanline;
+
+    for (uint32_t const GLYPH : testGlyphs)
+    {
+      msdf_atlas::GlyphGeometry const& glyph = glyphData[GLYPH];
+
+      int boxX = 0, boxY = 0, boxW = 0, boxH = 0;
+      glyph.getBoxRect(boxX, boxY, boxW, boxH);
+
+      if (boxW <= 0 || boxH <= 0)
+        continue;
+
+      // Maps box pixels to shape coordinates: shape = pixel / scale - translate
+      double const BOX_SCALE = glyph.getBoxScale();
+      msdfgen::Vector2 const BOX_TRANSLATE = glyph.getBoxTranslate();
+
+      uint32_t const BOX_WIDTH = static_cast<uint32_t>(boxW);
+      uint32_t const BOX_HEIGHT = static_cast<uint32_t>(boxH);
+
+      for (uint32_t c = 0; c < 3; ++c)
+      {
+        boxTexels[c].resize(BOX_WIDTH * BOX_HEIGHT);
+        sampleRow[c].resize(BOX_WIDTH + 3);
+      }
+
+      glyphBitmap.resize(static_cast<size_t>(BOX_WIDTH) * BOX_HEIGHT * NUM_CHANNELS);
+      FontCompiler::GenerateGlyphBitmap(glyph.getShape(), glyph.getBoxProjection(), glyph.getBoxRange(), BOX_WIDTH, BOX_HEIGHT, glyphBitmap.data(), BOX_WIDTH);
+
+      uint8_t const* texel = glyphBitmap.data();
+      for (uint32_t i = 0; i < BOX_WIDTH * BOX_HEIGHT; ++i, texel += NUM_CHANNELS)
+      {
+        for (uint32_t c = 0; c < 3; ++c)
+          boxTexels[c][i] = texel[c] / 255.0f;
+      }
+
+      for (uint32_t row = 0; row < BOX_HEIGHT * SAMPLES_PER_TEXEL; ++row)
+      {
+        // Texel rows the sample row lies between (clamped to the box) and how far it is from the first
+        float const TEXEL_Y = (row + 0.5f) / SAMPLES_PER_TEXEL - 0.5f;
+        float const FLOOR_Y = std::floor(TEXEL_Y);
+        float const WEIGHT_Y = TEXEL_Y - FLOOR_Y;
+        uint32_t const ROW0 = static_cast<uint32_t>(std::clamp(static_cast<int>(FLOOR_Y), 0, boxH - 1));
+        uint32_t const ROW1 = static_cast<uint32_t>(std::clamp(static_cast<int>(FLOOR_Y) + 1, 0, boxH - 1));
+
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+          float const* texels0 = boxTexels[c].data() + ROW0 * BOX_WIDTH;
+          float const* texels1 = boxTexels[c].data() + ROW1 * BOX_WIDTH;
+          float* dst = sampleRow[c].data() + 1;
+
+          uint32_t x = 0;
+
+#ifdef DASH_TOOLS_SSE2
+          __m128 const WEIGHT = _mm_set1_ps(WEIGHT_Y);
+          for (; x + 4 <= BOX_WIDTH; x += 4)
+          {
+            __m128 const TOP = _mm_loadu_ps(texels0 + x);
+            __m128 const BOTTOM = _mm_loadu_ps(texels1 + x);
+            _mm_storeu_ps(dst + x, _mm_add_ps(TOP, _mm_mul_ps(_mm_sub_ps(BOTTOM, TOP), WEIGHT)));
+          }
+#endif
+
+          for (; x < BOX_WIDTH; ++x)
+            dst[x] = texels0[x] + (texels1[x] - texels0[x]) * WEIGHT_Y;
+
+          // Clamp to the edge of the box instead of sampling neighbouring glyphs
+          sampleRow[c][0] = sampleRow[c][1];
+          sampleRow[c][BOX_WIDTH + 1] = sampleRow[c][BOX_WIDTH];
+          sampleRow[c][BOX_WIDTH + 2] = sampleRow[c][BOX_WIDTH];
+        }
+
+        // Reference coverage straight from the outline
+        double const SHAPE_Y = (row + 0.5) / SAMPLES_PER_TEXEL / BOX_SCALE - BOX_TRANSLATE.y;
+        glyph.getShape().scanline(scanline, SHAPE_Y);
+
+        for (uint32_t x = 0; x < BOX_WIDTH; ++x)
+        {
+          uint32_t reference = 0;
+          for (uint32_t sample = 0; sample < SAMPLES_PER_TEXEL; ++sample)
+          {
+            double const SHAPE_X = (x + (sample + 0.5) / SAMPLES_PER_TEXEL) / BOX_SCALE - BOX_TRANSLATE.x;
+            if (scanline.filled(SHAPE_X, msdfgen::FILL_NONZERO))
+              reference |= 1u << sample;
+          }
+
+          uint32_t const RECONSTRUCTED = ReconstructTexel(sampleRow[0].data(), sampleRow[1].data(), sampleRow[2].data(), x);
+
+          mismatchedSamples += std::popcount(reference ^ RECONSTRUCTED);
+          insideSamples += std::popcount(reference);
+        }
+      }
+    }
+
+    if (insideSamples == 0)
+      return 0.0;
+
+    return static_cast<double>(mismatchedSamples) / static_cast<double>(insideSamples);
+  }
+
+  /***************************************************************************/
+  /*!
+
+    \brief
+      Reconstructs the SAMPLES_PER_TEXEL samples that fall inside 1 texel of
+      a vertically interpolated row. With 4 samples per texel, the first 2 
+      lie between the previous texel and this one and the last 2 between 
+      this one and the next, so every sample is a lerp of 2 lanes of the 4 
+      texels around it with a fixed weight.
+
+    \param red
+      Red channel of the row, padded with 1 texel on the left.
+
+    \param green
+      Green channel of the row, padded with 1 texel on the left.
+
+    \param blue
+      Blue channel of the row, padded with 1 texel on the left.
+
+    \param texel
+      Index of the texel in the row (without padding).
+
+    \return
+      Bit mask of the samples that are inside the glyph.
+
+  */
+  /***************************************************************************/
+  uint32_t FontAtlasTuner::ReconstructTexel(float const* red, float const* green, float const* blue, uint32_t texel) noexcept
+  {
+    static_assert(SAMPLES_PER_TEXEL == 4, "Sample weights below assume 4 samples per texel");
+
+#ifdef DASH_TOOLS_SSE2
+    __m128 const WEIGHTS = _mm_setr_ps(0.625f, 0.875f, 0.125f, 0.375f);
+
+    auto const SAMPLE = [&WEIGHTS, texel](float const* channel)
+    {
+      // Texels (previous, current, next, next + 1)
+      __m128 const TEXELS = _mm_loadu_ps(channel + texel);
+      __m128 const LEFT = _mm_shuffle_ps(TEXELS, TEXELS, _MM_SHUFFLE(1, 1, 0, 0));
+      __m128 const RIGHT = _mm_shuffle_ps(TEXELS, TEXELS, _MM_SHUFFLE(2, 2, 1, 1));
+      return _mm_add_ps(LEFT, _mm_mul_ps(_mm_sub_ps(RIGHT, LEFT), WEIGHTS));
+    };
+
+    __m128 const R = SAMPLE(red);
+    __m128 const G = SAMPLE(green);
+    __m128 const B = SAMPLE(blue);
+
+    // Median of the 3 channels
+    __m128 const MEDIAN = _mm_max_ps(_mm_min_ps(R, G), _mm_min_ps(_mm_max_ps(R, G), B));
+
+    return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmpgt_ps(MEDIAN, _mm_set1_ps(0.5f))));
+#else
+    static constexpr float WEIGHTS[4] = { 0.625f, 0.875f, 0.125f, 0.375f };
+    static constexpr uint32_t LEFT[4] = { 0, 0, 1, 1 };
+
+    uint32_t mask = 0;
+    for (uint32_t sample = 0; sample < SAMPLES_PER_TEXEL; ++sample)
+    {
+      uint32_t const INDEX = texel + LEFT[sample];
+      float const R = red[INDEX] + (red[INDEX + 1] - red[INDEX]) * WEIGHTS[sample];
+      float const G = green[INDEX] + (green[INDEX + 1] - green[INDEX]) * WEIGHTS[sample];
+      float const B = blue[INDEX] + (blue[INDEX + 1] - blue[INDEX]) * WEIGHTS[sample];
+
+      float const MEDIAN = std::max(std::min(R, G), std::min(std::max(R, G), B));
+      if (MEDIAN > 0.5f)
+        mask |= 1u << sample;
+    }
+
+    return mask;
+#endif
+  }
+
+}
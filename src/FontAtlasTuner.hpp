@@ -0,0 +1,48 @@
+#pragma once
+
+#include "FontCompiler.hpp"
+
+namespace dash_tools
+{
+  struct FontAtlasTuning
+  {
+    // Parameters of the chosen atlas
+    FontAtlasParameters parameters;
+
+    // Glyphs already packed with those parameters so they don't have to be packed again
+    std::vector<msdf_atlas::GlyphGeometry> packedGlyphData;
+
+    // Dimensions of the packed atlas
+    int width;
+    int height;
+  };
+
+  class FontAtlasTuner
+  {
+  public:
+    // Maximum reconstruction error used when none is given
+    static constexpr double DEFAULT_MAX_ERROR = 0.02;
+
+    // Number of glyphs reconstructed to measure the error of a candidate atlas
+    static constexpr uint32_t MAX_TEST_GLYPHS = 64;
+
+    // Samples per atlas texel along each axis when reconstructing. Matches the SIMD width so 1 texel fills 1 register.
+    static constexpr uint32_t SAMPLES_PER_TEXEL = 4;
+
+    static constexpr double CANDIDATE_SCALES[] = { 8.0, 12.0, 16.0, 24.0, 32.0, 48.0, 64.0, 96.0 };
+    static constexpr double CANDIDATE_PIXEL_RANGES[] = { 2.0, 4.0 };
+    static constexpr msdf_atlas::TightAtlasPacker::DimensionsConstraint CANDIDATE_CONSTRAINTS[] = 
+    {
+      msdf_atlas::TightAtlasPacker::DimensionsConstraint::SQUARE,
+      msdf_atlas::TightAtlasPacker::DimensionsConstraint::POWER_OF_TWO_SQUARE,
+      msdf_atlas::TightAtlasPacker::DimensionsConstraint::POWER_OF_TWO_RECTANGLE,
+    };
+
+    static std::optional<FontAtlasTuning> FindParameters             (std::vector<msdf_atlas::GlyphGeometry> const& glyphData, FontAtlasBudget const& budget) noexcept;
+    static double                         MeasureReconstructionError (std::vector<msdf_atlas::GlyphGeometry> const& glyphData, std::vector<uint32_t> const& testGlyphs) noexcept;
+
+  private:
+    static uint32_t ReconstructTexel (float const* red, float const* green, float const* blue, uint32_t texel) noexcept;
+
+  };
+}
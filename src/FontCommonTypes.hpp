@@ -28,6 +28,21 @@ namespace dash_tools
   static constexpr uint32_t GLYPH_POS_X_ARRAY_INDEX = 10;
   static constexpr uint32_t GLYPH_POS_Y_ARRAY_INDEX = 11;
 
+  // Pixel range of fonts compiled before it was stored in the file
+  static constexpr float DEFAULT_FONT_PIXEL_RANGE = 2.0f;
+
+  // Mip chain generation stops once the next level would have a dimension smaller than this.
+  // Below this size the distance field is too coarse for any glyph to be reconstructed.
+  static constexpr uint32_t FONT_MIN_MIP_DIMENSION = 16;
+  static constexpr uint32_t FONT_MAX_MIP_LEVELS = 3;
+
+  // Pixels between glyph boxes in the full size bitmap. Keeps boxes at least 1 texel apart on the smallest mip level.
+  static constexpr uint32_t FONT_MIP_GLYPH_SPACING = 1u << FONT_MAX_MIP_LEVELS;
+
+  // Written in place of the glyph count at the start of the file, followed by the mapping count and the glyph data count.
+  // Glyphs sharing an outline share their data, so the two counts differ. Older files start with a single count used for both.
+  static constexpr uint32_t FONT_SEPARATE_GLYPH_COUNTS_TAG = 0xFFFFFFFF;
+
 
   struct GlyphIndexingData
   {
@@ -47,6 +62,34 @@ namespace dash_tools
     float kerning;
   };
 
+  // A single glyph of laid out text, ready to be turned into vertices
+  struct GlyphQuad
+  {
+    // Bottom left corner of the quad relative to the origin of the text
+    float position[2];
+
+    // Size of the quad
+    float scale[2];
+
+    // Bottom left corner of the glyph in the bitmap (normalized)
+    float uvOffset[2];
+
+    // Size of the glyph in the bitmap (normalized)
+    float uvScale[2];
+  };
+
+  struct FontBitmapLevel
+  {
+    // Bitmap data of this level
+    std::vector<BitmapPixelType> bitmap;
+
+    // Width of this level
+    uint32_t width;
+
+    // Height of this level
+    uint32_t height;
+  };
+
   struct UnpackedFontData
   {
     // Maps glyph characters to index into glyph data vector
@@ -69,6 +112,16 @@ namespace dash_tools
     // I could have stored a map of doubles and then static_cast later, but I wanted it to be more obvious what's going into the binary file.
     KernPairData kernPairs;
 
+    // Smaller levels of the bitmap. The first element is half the size of fontBitmap, the next is a quarter and so on.
+    // Each level is generated from the outlines with the same distance range in texels as fontBitmap.
+    // Glyph uv data is normalized so it is valid for every level.
+    std::vector<FontBitmapLevel> mipLevels;
+
+    // Width of the distance range around glyph edges in texels. The same for fontBitmap and every mip level,
+    // which means the range in uv space differs per level. The runtime needs it, together with the size of the 
+    // sampled level, to work out the range in screen pixels.
+    float pixelRange;
+
     UnpackedFontData (void) = default;
     UnpackedFontData (UnpackedFontData&& rhs) noexcept = default;
 
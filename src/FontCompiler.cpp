@@ -1,9 +1,20 @@
 #include "FontCompiler.hpp"
+#include "FontMipmapper.hpp"
+#include "FontAtlasTuner.hpp"
+#include "Utf8.hpp"
 #include "msdfgen/include/lodepng.h"
 
 
 #include <fstream>
 #include <iostream>
+#include <algorithm>
+#include <unordered_map>
+#include <iomanip>
+#include <bit>
+
+#ifdef DASH_TOOLS_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace dash_tools
 {
@@ -18,10 +29,14 @@ namespace dash_tools
       The ptr to the font asset.
 
     \param glyphData
-      Individual glyph data.
+      Individual glyph data of every glyph in the charset.
+
+    \param uniqueGlyphData
+      Glyphs with unique shapes that were packed into the atlas.
 
-    \param fontBitmap
-      Actual bitmap data
+    \param uniqueGlyphIndices
+      For every glyph in glyphData, the index of the glyph in 
+      uniqueGlyphData with the same shape.
 
     \param fontGeometry
      Font geometry required to get advance
@@ -29,7 +44,9 @@ namespace dash_tools
   */
   /***************************************************************************/
   void FontCompiler::GenerateUnpackedFontData(UnpackedFontData&                             unpackedFontData, 
-                                              std::vector<msdf_atlas::GlyphGeometry> const& glyphGeometry, 
+                                              std::vector<msdf_atlas::GlyphGeometry> const& glyphData, 
+                                              std::vector<msdf_atlas::GlyphGeometry> const& uniqueGlyphData, 
+                                              std::vector<uint32_t> const&                  uniqueGlyphIndices, 
                                               msdf_atlas::FontGeometry const&               fontGeometry) noexcept
   {
 
@@ -37,9 +54,22 @@ namespace dash_tools
     uint32_t const BITMAP_WIDTH = unpackedFontData.bitmapWidth;
     uint32_t const BITMAP_HEIGHT = unpackedFontData.bitmapHeight;
 
-    uint32_t const NUM_GLYPHS = static_cast<uint32_t>(glyphGeometry.size());
-    for (uint32_t i = 0; i < NUM_GLYPHS; ++i)
+    // Glyphs sharing a shape and advance share the same glyph data. Maps those 2 to the index of the glyph data.
+    std::map<std::pair<uint32_t, double>, uint32_t> sharedGlyphData;
+
+    uint32_t const NUM_GLYPHS = static_cast<uint32_t>(glyphData.size());
+    for (uint32_t glyph = 0; glyph < NUM_GLYPHS; ++glyph)
     {
+      // Index of the glyph in the atlas
+      uint32_t const i = uniqueGlyphIndices[glyph];
+      double const ADVANCE = glyphData[glyph].getAdvance();
+
+      auto [it, inserted] = sharedGlyphData.emplace(std::pair{ i, ADVANCE }, static_cast<uint32_t>(unpackedFontData.glyphData.size()));
+      unpackedFontData.glyphMappings.emplace(static_cast<GlyphType>(glyphData[glyph].getCodepoint()), it->second);
+
+      if (!inserted)
+        continue;
+
       // bounding box of the glyph in atlas
     	double atlasL = 0.0, atlasR = 0.0, atlasT = 0.0, atlasB = 0.0;
 
@@ -47,10 +77,10 @@ namespace dash_tools
       double atlasPL = 0.0, atlasPR = 0.0, atlasPT = 0.0, atlasPB = 0.0;
 
       // Get the glyph's bounding box in bitmap space. 
-      glyphGeometry[i].getQuadAtlasBounds(atlasL, atlasB, atlasR, atlasT);
+      uniqueGlyphData[i].getQuadAtlasBounds(atlasL, atlasB, atlasR, atlasT);
 
       // Get the quad's 
-      glyphGeometry[i].getQuadPlaneBounds(atlasPL, atlasPB, atlasPR, atlasPT);
+      uniqueGlyphData[i].getQuadPlaneBounds(atlasPL, atlasPB, atlasPR, atlasPT);
 
       // normalize the bounding box to 0.0f-1.0f (i.e. texture space) 
       atlasL /= BITMAP_WIDTH;
@@ -69,7 +99,7 @@ namespace dash_tools
       { 
         {
           // For scaling the tex coords
-          NORMALIZED_TEX_DIMS[0],     NORMALIZED_TEX_DIMS[1],     0.0f,                        static_cast<GlyphKerningType>(glyphGeometry[i].getAdvance()),
+          NORMALIZED_TEX_DIMS[0],     NORMALIZED_TEX_DIMS[1],     0.0f,                        static_cast<GlyphKerningType>(ADVANCE),
 
           // For translating the tex coords to correct offset in bitmap texture
           static_cast<float>(atlasL), static_cast<float>(atlasB), 1.0f,                        0.0f,
@@ -83,7 +113,6 @@ namespace dash_tools
 
       // Push 1 set of data for a character/glyph into the asset.
       unpackedFontData.glyphData.push_back(currentGlyphData);
-      unpackedFontData.glyphMappings.emplace(static_cast<GlyphType>(glyphGeometry[i].getCodepoint()), i);
     }
 
     // font geometry kerning
@@ -94,6 +123,135 @@ namespace dash_tools
       unpackedFontData.kernPairs.emplace(PAIR, static_cast<float> (KERNING));
   }
 
+  /***************************************************************************/
+  /*!
+  
+    \brief
+      Finds glyphs with identical outlines so each shape is only packed and
+      generated once. Shapes are bucketed by hash and compared in full 
+      before being treated as the same shape.
+    
+    \param glyphData
+      Individual glyph data of every glyph in the charset.
+
+    \param uniqueGlyphData
+      Filled with 1 glyph for every unique shape.
+   
+    \return 
+      For every glyph in glyphData, the index of the glyph in uniqueGlyphData
+      with the same shape.
+  
+  */
+  /***************************************************************************/
+  std::vector<uint32_t> FontCompiler::DeduplicateGlyphs(std::vector<msdf_atlas::GlyphGeometry> const& glyphData, 
+                                                        std::vector<msdf_atlas::GlyphGeometry>&       uniqueGlyphData) noexcept
+  {
+    std::vector<uint32_t> uniqueGlyphIndices(glyphData.size());
+
+    // Signature of every unique shape and the indices of unique shapes for every hash
+    std::vector<std::vector<double>> uniqueSignatures;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> shapeBuckets;
+
+    uniqueGlyphData.clear();
+
+    std::vector<double> signature;
+    for (size_t i = 0; i < glyphData.size(); ++i)
+    {
+      uint64_t const HASH = HashGlyphShape(glyphData[i].getShape(), signature);
+      std::vector<uint32_t>& bucket = shapeBuckets[HASH];
+
+      auto const MATCH = std::find_if(bucket.begin(), bucket.end(), [&](uint32_t uniqueIndex)
+      {
+        return uniqueSignatures[uniqueIndex] == signature;
+      });
+
+      if (MATCH != bucket.end())
+      {
+        uniqueGlyphIndices[i] = *MATCH;
+        continue;
+      }
+
+      uint32_t const NEW_INDEX = static_cast<uint32_t>(uniqueGlyphData.size());
+      bucket.push_back(NEW_INDEX);
+      uniqueSignatures.push_back(signature);
+      uniqueGlyphData.push_back(glyphData[i]);
+      uniqueGlyphIndices[i] = NEW_INDEX;
+    }
+
+    return uniqueGlyphIndices;
+  }
+
+  /***************************************************************************/
+  /*!
+  
+    \brief
+      Flattens the contours of a shape into a list of numbers (edge counts,
+      control point counts and control points) and hashes it with 64 bit 
+      FNV-1a. 2 shapes with equal signatures render identically.
+    
+    \param shape
+      Shape to hash.
+
+    \param shapeSignature
+      Filled with the flattened contours.
+   
+    \return 
+      Hash of the signature.
+  
+  */
+  /***************************************************************************/
+  uint64_t FontCompiler::HashGlyphShape(msdfgen::Shape const& shape, std::vector<double>& shapeSignature) noexcept
+  {
+    shapeSignature.clear();
+
+    for (msdfgen::Contour const& contour : shape.contours)
+    {
+      shapeSignature.push_back(static_cast<double>(contour.edges.size()));
+
+      for (msdfgen::EdgeHolder const& edge : contour.edges)
+      {
+        msdfgen::EdgeSegment const* segment = edge;
+
+        // Control points of the segment, depending on its type
+        msdfgen::Point2 const* points = nullptr;
+        size_t numPoints = 0;
+
+        if (auto const* linear = dynamic_cast<msdfgen::LinearSegment const*>(segment))
+        {
+          points = linear->p;
+          numPoints = 2;
+        }
+        else if (auto const* quadratic = dynamic_cast<msdfgen::QuadraticSegment const*>(segment))
+        {
+          points = quadratic->p;
+          numPoints = 3;
+        }
+        else if (auto const* cubic = dynamic_cast<msdfgen::CubicSegment const*>(segment))
+        {
+          points = cubic->p;
+          numPoints = 4;
+        }
+
+        shapeSignature.push_back(static_cast<double>(numPoints));
+        for (size_t i = 0; i < numPoints; ++i)
+        {
+          shapeSignature.push_back(points[i].x);
+          shapeSignature.push_back(points[i].y);
+        }
+      }
+    }
+
+    uint64_t hash = 0xCBF29CE484222325ull;
+    uint8_t const* bytes = reinterpret_cast<uint8_t const*>(shapeSignature.data());
+    for (size_t i = 0; i < shapeSignature.size() * sizeof(double); ++i)
+    {
+      hash ^= bytes[i];
+      hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+  }
+
   /***************************************************************************/
   /*!
   
@@ -103,13 +261,16 @@ namespace dash_tools
     
     \param path
       Path to the font file (truetype font file) to load.
+
+    \param budget
+      If given, the atlas parameters are tuned to fit this budget.
    
     \return 
       Path to newly created binary data.
   
   */
   /***************************************************************************/
-  std::optional<AssetPath> FontCompiler::LoadAndCompileFont(msdfgen::FreetypeHandle* freetypeHandle, AssetPath path) noexcept
+  std::optional<AssetPath> FontCompiler::LoadAndCompileFont(msdfgen::FreetypeHandle* freetypeHandle, AssetPath path, std::optional<FontAtlasBudget> const& budget) noexcept
   {
     msdfgen::FontHandle* fontHandle = nullptr;
     
@@ -118,12 +279,18 @@ namespace dash_tools
     if (fontHandle)
     {
       // Extract relevant memory from font handle
-      auto* unpackedFontData = CompileFontToMemory(fontHandle, path);
+      auto* unpackedFontData = CompileFontToMemory(fontHandle, path, msdf_atlas::Charset::ASCII, budget);
 
       // No path to binary format
       if (!unpackedFontData)
         return {};
 
+      // The full charset replaces any subset compiled before, so its manifest no longer applies
+      AssetPath manifestPath{ path };
+      manifestPath.replace_extension(FONT_SUBSET_MANIFEST_EXTENSION);
+      std::error_code error;
+      std::filesystem::remove(manifestPath, error);
+
       return PackFontDataToFile(path, *unpackedFontData);
     }
 
@@ -132,6 +299,420 @@ namespace dash_tools
     return {};
   }
 
+  /***************************************************************************/
+  /*!
+  
+    \brief
+      Loads and compiles only the given codepoints of a font. Coverage of the
+      charset and the atlas bytes saved compared to the default charset are
+      reported. A manifest of the charset is written next to the binary so
+      the font is only recompiled when the charset or the font changes.
+    
+    \param path
+      Path to the font file (truetype font file) to load.
+
+    \param charset
+      Codepoints to compile, usually from LoadCorpusCharset.
+
+    \param budget
+      If given, the atlas parameters are tuned to fit this budget.
+   
+    \return 
+      Path to the binary data.
+  
+  */
+  /***************************************************************************/
+  std::optional<AssetPath> FontCompiler::LoadAndCompileFontSubset(msdfgen::FreetypeHandle* freetypeHandle, AssetPath path, msdf_atlas::Charset const& charset, std::optional<FontAtlasBudget> const& budget) noexcept
+  {
+    uint64_t charsetHash = HashCharset(charset);
+
+    // A different budget gives a different atlas, so it is part of what the manifest records
+    if (budget)
+    {
+      charsetHash ^= budget->maxBytes + 0x9E3779B97F4A7C15ull + (charsetHash << 6) + (charsetHash >> 2);
+      charsetHash ^= std::bit_cast<uint64_t>(budget->maxError) + 0x9E3779B97F4A7C15ull + (charsetHash << 6) + (charsetHash >> 2);
+    }
+
+    uint64_t const CHARSET_HASH = charsetHash;
+
+    AssetPath binaryPath{ path };
+    binaryPath.replace_extension(FONT_EXTENSION);
+
+    if (IsSubsetUpToDate(path, CHARSET_HASH))
+    {
+      std::cout << "Subset is up to date: " << binaryPath.string() << std::endl;
+      return binaryPath;
+    }
+
+    msdfgen::FontHandle* fontHandle = msdfgen::loadFont(freetypeHandle, path.string().c_str());
+
+    if (!fontHandle)
+    {
+      std::cout << "Unable to open font file: " << path.string() << std::endl;
+      return {};
+    }
+
+    FontAtlasParameters atlasParameters{};
+    auto* unpackedFontData = CompileFontToMemory(fontHandle, path, charset, budget, &atlasParameters);
+
+    if (!unpackedFontData)
+    {
+      msdfgen::destroyFont(fontHandle);
+      return {};
+    }
+
+    // Coverage report. Codepoints missing from the font can't be compiled.
+    std::vector<msdf_atlas::unicode_t> missingCodepoints;
+    for (msdf_atlas::unicode_t const CODEPOINT : charset)
+    {
+      if (unpackedFontData->glyphMappings.count(static_cast<GlyphType>(CODEPOINT)) == 0)
+        missingCodepoints.push_back(CODEPOINT);
+    }
+
+    std::cout << "Subset of " << path.string() << ": " << charset.size() - missingCodepoints.size() << " of " << charset.size() << " codepoints covered" << std::endl;
+
+    if (!missingCodepoints.empty())
+    {
+      // Only list a few, the count is what matters for large scripts
+      static constexpr size_t MAX_LISTED_CODEPOINTS = 16;
+
+      std::cout << "  Missing:";
+      for (size_t i = 0; i < std::min(missingCodepoints.size(), MAX_LISTED_CODEPOINTS); ++i)
+        std::cout << " U+" << std::hex << std::uppercase << std::setw(4) << std::setfill('0') << missingCodepoints[i] << std::dec << std::nouppercase;
+
+      if (missingCodepoints.size() > MAX_LISTED_CODEPOINTS)
+        std::cout << " ...";
+
+      std::cout << std::endl;
+    }
+
+    // Compare against the atlas of every codepoint the font covers, packed with the same parameters as the subset
+    msdf_atlas::Charset const FONT_CHARSET = LoadFontCharset(fontHandle);
+    uint32_t const SUBSET_BYTES = unpackedFontData->bitmapWidth * unpackedFontData->bitmapHeight * BYTES_PER_CHANNEL * NUM_CHANNELS;
+    uint32_t const FULL_BYTES = MeasureAtlasBytes(fontHandle, FONT_CHARSET, atlasParameters);
+
+    std::cout << "  Atlas: " << unpackedFontData->bitmapWidth << "x" << unpackedFontData->bitmapHeight << " (" << SUBSET_BYTES << " bytes), "
+              << "full font (" << FONT_CHARSET.size() << " codepoints): " << FULL_BYTES << " bytes, "
+              << "saved: " << static_cast<int64_t>(FULL_BYTES) - static_cast<int64_t>(SUBSET_BYTES) << " bytes" << std::endl;
+
+    msdfgen::destroyFont(fontHandle);
+
+    std::string const NEW_PATH = PackFontDataToFile(path, *unpackedFontData);
+
+    // Only record the charset once the binary is written
+    AssetPath manifestPath{ path };
+    manifestPath.replace_extension(FONT_SUBSET_MANIFEST_EXTENSION);
+
+    std::ofstream manifest{ manifestPath, std::ios::out | std::ios::trunc };
+    manifest << CHARSET_HASH << " " << charset.size() << std::endl;
+
+    return NEW_PATH;
+  }
+
+  /***************************************************************************/
+  /*!
+  
+    \brief
+      Reads UTF-8 text files and collects every codepoint used in them.
+      Control characters are skipped since they have no glyph.
+    
+    \param corpusPaths
+      Paths to the UTF-8 text files.
+   
+    \return 
+      Charset of the codepoints used, or nothing if a file can't be read.
+  
+  */
+  /***************************************************************************/
+  std::optional<msdf_atlas::Charset> FontCompiler::LoadCorpusCharset(std::vector<AssetPath> const& corpusPaths) noexcept
+  {
+    msdf_atlas::Charset charset;
+
+    for (AssetPath const& corpusPath : corpusPaths)
+    {
+      std::ifstream ifs{ corpusPath, std::ios::binary };
+
+      if (!ifs.is_open())
+      {
+        std::cout << "Unable to open corpus file: " << corpusPath.string() << std::endl;
+        return {};
+      }
+
+      std::string const TEXT{ std::istreambuf_iterator<char>{ ifs }, std::istreambuf_iterator<char>{} };
+
+      size_t cursor = 0;
+
+      // Skip the byte order mark
+      if (TEXT.compare(0, 3, "\xEF\xBB\xBF") == 0)
+        cursor = 3;
+
+      while (cursor < TEXT.size())
+      {
+        size_t const START = cursor;
+        GlyphType const CODEPOINT = DecodeUtf8(TEXT, cursor);
+
+        // Malformed sequences decode to the replacement character, only keep it when the text actually encodes it
+        if (CODEPOINT == UTF8_REPLACEMENT_CHARACTER && TEXT.compare(START, cursor - START, "\xEF\xBF\xBD") != 0)
+          continue;
+
+        if (CODEPOINT < 0x20 || (CODEPOINT >= 0x7F && CODEPOINT < 0xA0))
+          continue;
+
+        charset.add(static_cast<msdf_atlas::unicode_t>(CODEPOINT));
+      }
+    }
+
+    std::cout << "Corpus uses " << charset.size() << " codepoints" << std::endl;
+
+    return charset;
+  }
+
+  /***************************************************************************/
+  /*!
+  
+    \brief
+      Sets the parameters every atlas is packed with.
+    
+    \param atlasPacker
+      Packer to configure.
+
+    \param parameters
+      Scale, pixel range and dimensions constraint to pack with.
+  
+  */
+  /***************************************************************************/
+  void FontCompiler::ConfigureAtlasPacker(msdf_atlas::TightAtlasPacker& atlasPacker, FontAtlasParameters const& parameters) noexcept
+  {
+    atlasPacker.setDimensionsConstraint(parameters.dimensionsConstraint);
+
+    atlasPacker.setMinimumScale(parameters.minimumScale);
+    atlasPacker.setPixelRange(parameters.pixelRange);
+    atlasPacker.setMiterLimit(1.0);
+
+    // Mip levels are generated into the same boxes scaled down, so they need room to not overlap
+    atlasPacker.setSpacing(static_cast<int>(FONT_MIP_GLYPH_SPACING));
+  }
+
+  /***************************************************************************/
+  /*!
+  
+    \brief
+      Generates the MTSDF of a single glyph and writes it as 8 bit RGBA 
+      into a bitmap. Values are converted the same way msdf-atlas-gen 
+      converts its atlas.
+    
+    \param shape
+      Edge colored shape of the glyph.
+
+    \param projection
+      Maps shape coordinates to pixels of the output.
+
+    \param range
+      Distance range in shape units.
+
+    \param width
+      Width of the output in pixels.
+
+    \param height
+      Height of the output in pixels.
+
+    \param dst
+      First pixel of the output, bottom row first.
+
+    \param dstStride
+      Pixels between the starts of 2 rows in dst.
+  
+  */
+  /***************************************************************************/
+  void FontCompiler::GenerateGlyphBitmap(msdfgen::Shape const& shape, msdfgen::Projection const& projection, double range, 
+                                         uint32_t width, uint32_t height, uint8_t* dst, uint32_t dstStride) noexcept
+  {
+    msdfgen::Bitmap<float, 4> glyphBitmap(static_cast<int>(width), static_cast<int>(height));
+    msdfgen::generateMTSDF(glyphBitmap, shape, projection, range);
+
+    float const* src = glyphBitmap;
+
+    for (uint32_t y = 0; y < height; ++y)
+    {
+      float const* srcRow = src + static_cast<size_t>(y) * width * NUM_CHANNELS;
+      uint8_t* dstRow = dst + static_cast<size_t>(y) * dstStride * NUM_CHANNELS;
+
+      uint32_t i = 0;
+
+#ifdef DASH_TOOLS_SSE2
+      // 4 pixels per iteration, byte = clamp(256 * value, 0, 255)
+      __m128 const SCALE = _mm_set1_ps(256.0f);
+      __m128 const ZERO = _mm_setzero_ps();
+      __m128 const MAX = _mm_set1_ps(255.0f);
+
+      for (; i + 16 <= width * NUM_CHANNELS; i += 16)
+      {
+        __m128i converted[4];
+        for (uint32_t j = 0; j < 4; ++j)
+        {
+          __m128 const VALUE = _mm_mul_ps(_mm_loadu_ps(srcRow + i + j * 4), SCALE);
+          converted[j] = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(VALUE, ZERO), MAX));
+        }
+
+        __m128i const PACKED = _mm_packus_epi16(_mm_packs_epi32(converted[0], converted[1]), _mm_packs_epi32(converted[2], converted[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dstRow + i), PACKED);
+      }
+#endif
+
+      for (; i < width * NUM_CHANNELS; ++i)
+        dstRow[i] = static_cast<uint8_t>(std::clamp(256.0f * srcRow[i], 0.0f, 255.0f));
+    }
+  }
+
+  /***************************************************************************/
+  /*!
+  
+    \brief
+      Packs a charset without generating it to find the size of its atlas.
+    
+    \param fontHandle
+      Font to load the charset from.
+
+    \param charset
+      Codepoints to pack.
+
+    \param parameters
+      Parameters to pack with.
+   
+    \return 
+      Size of the atlas in bytes.
+  
+  */
+  /***************************************************************************/
+  uint32_t FontCompiler::MeasureAtlasBytes(msdfgen::FontHandle* fontHandle, msdf_atlas::Charset const& charset, FontAtlasParameters const& parameters) noexcept
+  {
+    std::vector<msdf_atlas::GlyphGeometry> glyphData;
+    msdf_atlas::FontGeometry fontGeometry(&glyphData);
+    fontGeometry.loadCharset(fontHandle, 1.0, charset);
+
+    std::vector<msdf_atlas::GlyphGeometry> uniqueGlyphData;
+    DeduplicateGlyphs(glyphData, uniqueGlyphData);
+
+    msdf_atlas::TightAtlasPacker atlasPacker;
+    ConfigureAtlasPacker(atlasPacker, parameters);
+    atlasPacker.pack(uniqueGlyphData.data(), static_cast<int>(uniqueGlyphData.size()));
+
+    int width = 0, height = 0;
+    atlasPacker.getDimensions(width, height);
+
+    return static_cast<uint32_t>(width * height) * BYTES_PER_CHANNEL * NUM_CHANNELS;
+  }
+
+  /***************************************************************************/
+  /*!
+  
+    \brief
+      Builds a charset of every codepoint the font's character map has a 
+      glyph for, by looking up each valid codepoint. Control characters 
+      are skipped the same way LoadCorpusCharset skips them.
+    
+    \param fontHandle
+      Font to read the character map of.
+   
+    \return 
+      Charset of the codepoints the font covers.
+  
+  */
+  /***************************************************************************/
+  msdf_atlas::Charset FontCompiler::LoadFontCharset(msdfgen::FontHandle* fontHandle) noexcept
+  {
+    static constexpr msdf_atlas::unicode_t MAX_CODEPOINT = 0x10FFFF;
+
+    msdf_atlas::Charset charset;
+
+    for (msdf_atlas::unicode_t codepoint = 0x20; codepoint <= MAX_CODEPOINT; ++codepoint)
+    {
+      // Control characters and surrogates have no glyphs of their own
+      if ((codepoint >= 0x7F && codepoint < 0xA0) || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+        continue;
+
+      msdfgen::GlyphIndex glyphIndex;
+      if (msdfgen::getGlyphIndex(glyphIndex, fontHandle, codepoint))
+        charset.add(codepoint);
+    }
+
+    return charset;
+  }
+
+  /***************************************************************************/
+  /*!
+  
+    \brief
+      64 bit FNV-1a hash of the codepoints in a charset.
+    
+    \param charset
+      Charset to hash.
+   
+    \return 
+      The hash.
+  
+  */
+  /***************************************************************************/
+  uint64_t FontCompiler::HashCharset(msdf_atlas::Charset const& charset) noexcept
+  {
+    // Charset is ordered so equal sets always hash the same
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (msdf_atlas::unicode_t const CODEPOINT : charset)
+    {
+      for (uint32_t i = 0; i < sizeof(CODEPOINT); ++i)
+      {
+        hash ^= (CODEPOINT >> (i * 8)) & 0xFF;
+        hash *= 0x100000001B3ull;
+      }
+    }
+
+    return hash;
+  }
+
+  /***************************************************************************/
+  /*!
+  
+    \brief
+      Checks if a font was already compiled with the same charset and has
+      not changed since.
+    
+    \param path
+      Path to the font file.
+
+    \param charsetHash
+      Hash of the charset to compile.
+   
+    \return 
+      True if the existing binary can be kept.
+  
+  */
+  /***************************************************************************/
+  bool FontCompiler::IsSubsetUpToDate(AssetPath const& path, uint64_t charsetHash) noexcept
+  {
+    AssetPath binaryPath{ path };
+    binaryPath.replace_extension(FONT_EXTENSION);
+
+    AssetPath manifestPath{ path };
+    manifestPath.replace_extension(FONT_SUBSET_MANIFEST_EXTENSION);
+
+    std::error_code error;
+    if (!std::filesystem::exists(binaryPath, error) || !std::filesystem::exists(manifestPath, error))
+      return false;
+
+    // Font changed after it was compiled
+    auto const FONT_TIME = std::filesystem::last_write_time(path, error);
+    auto const BINARY_TIME = std::filesystem::last_write_time(binaryPath, error);
+    if (error || FONT_TIME > BINARY_TIME)
+      return false;
+
+    std::ifstream manifest{ manifestPath };
+    uint64_t manifestHash = 0;
+    if (!(manifest >> manifestHash))
+      return false;
+
+    return manifestHash == charsetHash;
+  }
+
   /***************************************************************************/
   /*!
   
@@ -142,13 +723,26 @@ namespace dash_tools
     
     \param fontHandle
       MSDF font handle required to initialize member variables in SHFontAsset.
+
+    \param path
+      Path to the font file. The atlas image is saved next to it.
+
+    \param charset
+      Codepoints to compile. Kerning pairs are only loaded between these.
+
+    \param budget
+      If given, the atlas parameters are tuned to fit this budget. Otherwise
+      the default FontAtlasParameters are used.
+
+    \param usedParameters
+      If not null, set to the parameters the atlas was packed with.
    
     \return 
       A pointer to an object storing data meant for the binary file.
   
   */
   /***************************************************************************/
-  UnpackedFontData const* FontCompiler::CompileFontToMemory(msdfgen::FontHandle* fontHandle, AssetPath path) noexcept
+  UnpackedFontData const* FontCompiler::CompileFontToMemory(msdfgen::FontHandle* fontHandle, AssetPath path, msdf_atlas::Charset const& charset, std::optional<FontAtlasBudget> const& budget, FontAtlasParameters* usedParameters) noexcept
   {
     // Dynamically allocate new asset
     UnpackedFontData* newData = new UnpackedFontData();
@@ -160,32 +754,60 @@ namespace dash_tools
     msdf_atlas::FontGeometry fontGeometry (&glyphData);
 
     // Load char set
-    fontGeometry.loadCharset(fontHandle, 1.0, msdf_atlas::Charset::ASCII);
+    fontGeometry.loadCharset(fontHandle, 1.0, charset);
+
+    // Codepoints with identical outlines are packed and generated only once
+    std::vector<msdf_atlas::GlyphGeometry> uniqueGlyphData;
+    std::vector<uint32_t> const UNIQUE_GLYPH_INDICES = DeduplicateGlyphs(glyphData, uniqueGlyphData);
+
+    if (uniqueGlyphData.size() < glyphData.size())
+      std::cout << "Deduplicated " << glyphData.size() - uniqueGlyphData.size() << " of " << glyphData.size() << " glyphs in " << path.string() << std::endl;
 
     // Apply MSDF edge coloring
     const double maxCornerAngle = 3.0;
-    for (msdf_atlas::GlyphGeometry& glyph : glyphData)
+    for (msdf_atlas::GlyphGeometry& glyph : uniqueGlyphData)
       glyph.edgeColoring(&msdfgen::edgeColoringInkTrap, maxCornerAngle, 0);
 
-    // configure parameters for atlas generation
-    msdf_atlas::TightAtlasPacker atlasPacker;
-    atlasPacker.setDimensionsConstraint(msdf_atlas::TightAtlasPacker::DimensionsConstraint::SQUARE);
+    FontAtlasParameters atlasParameters{};
+    int width = 0, height = 0;
 
-    atlasPacker.setMinimumScale(64.0);
-    atlasPacker.setPixelRange(2.0);
-    atlasPacker.setMiterLimit(1.0);
-    atlasPacker.pack(glyphData.data(), static_cast<int>(glyphData.size()));
+    // Search for the smallest atlas that is accurate enough if there is a budget to meet. The tuner returns the glyphs already packed.
+    std::optional<FontAtlasTuning> tuning{};
+    if (budget)
+    {
+      tuning = FontAtlasTuner::FindParameters(uniqueGlyphData, *budget);
+
+      if (tuning)
+      {
+        atlasParameters = tuning->parameters;
+        uniqueGlyphData = std::move(tuning->packedGlyphData);
+        width = tuning->width;
+        height = tuning->height;
+      }
+      else
+        std::cout << "No atlas fits the budget of " << budget->maxBytes << " bytes for " << path.string() << ", using default parameters" << std::endl;
+    }
 
-    // Get the dimensions after applying parameters
-    int width = 0, height = 0;
-    atlasPacker.getDimensions(width, height);
+    if (usedParameters)
+      *usedParameters = atlasParameters;
+
+    if (!tuning)
+    {
+      // configure parameters for atlas generation
+      msdf_atlas::TightAtlasPacker atlasPacker;
+      ConfigureAtlasPacker(atlasPacker, atlasParameters);
+      atlasPacker.pack(uniqueGlyphData.data(), static_cast<int>(uniqueGlyphData.size()));
+
+      // Get the dimensions after applying parameters
+      atlasPacker.getDimensions(width, height);
+    }
 
    // generate the atlas
-    msdf_atlas::ImmediateAtlasGenerator<float, 4, msdf_atlas::mtsdfGenerator, msdf_atlas::BitmapAtlasStorage<msdf_atlas::byte, 4>> generator(width, height);
+    FontAtlasGenerator generator(width, height);
     msdf_atlas::GeneratorAttributes genAttribs;
     generator.setAttributes(genAttribs);
     generator.setThreadCount(4);
-    generator.generate(glyphData.data(), static_cast<int>(glyphData.size()));
+    generator.generate(uniqueGlyphData.data(), static_cast<int>(uniqueGlyphData.size()));
 
     // Write to a separate image file that just contains the atlas for testing
     bool imageSaved = msdf_atlas::saveImage(generator.atlasStorage().operator msdfgen::BitmapConstRef<msdf_atlas::byte, 4>(),
@@ -203,13 +825,19 @@ namespace dash_tools
     uint32_t const BITMAP_BYTES = fontBitmap.width() * fontBitmap.height() * NUM_CHANNELS * BYTES_PER_CHANNEL;
     newData->bitmapWidth = fontBitmap.width();
     newData->bitmapHeight = fontBitmap.height();
-    newData->fontBitmap.resize(BITMAP_BYTES);
+    newData->fontBitmap.resize(static_cast<size_t>(fontBitmap.width()) * fontBitmap.height());
     std::memcpy(newData->fontBitmap.data(), fontBitmap.operator msdf_atlas::byte*(), BITMAP_BYTES);
 
+    // Shaders need the range to convert distances to screen pixels
+    newData->pixelRange = static_cast<float>(atlasParameters.pixelRange);
+
+    // Generate the mips here so the runtime doesn't have to generate them on load
+    FontMipmapper::GenerateMipChain(*newData, uniqueGlyphData);
+
     // at this point we have all the required data to initialize a font asset.
 
     // Now we populate it with data
-    GenerateUnpackedFontData(*newData, glyphData, fontGeometry);
+    GenerateUnpackedFontData(*newData, glyphData, uniqueGlyphData, UNIQUE_GLYPH_INDICES, fontGeometry);
 
     return newData;
   }
@@ -242,10 +870,11 @@ namespace dash_tools
     uint32_t const BITMAP_WIDTH = unpackedFontData.bitmapWidth;
     uint32_t const BITMAP_HEIGHT = unpackedFontData.bitmapHeight;
 
-    // Number of glyphs on stack for convenience
-    uint32_t const NUM_GLYPHS = static_cast<uint32_t>(unpackedFontData.glyphData.size());
+    // Number of glyph mappings and glyph data entries on stack for convenience, these differ when glyphs share data
+    uint32_t const NUM_GLYPH_MAPPINGS = static_cast<uint32_t>(unpackedFontData.glyphMappings.size());
+    uint32_t const NUM_GLYPH_DATA = static_cast<uint32_t>(unpackedFontData.glyphData.size());
 
-    uint32_t const GLYPH_MAPPING_BYTES = static_cast<uint32_t>(unpackedFontData.glyphMappings.size() * (sizeof(uint32_t) + sizeof(GlyphType)));
+    uint32_t const GLYPH_MAPPING_BYTES = static_cast<uint32_t>(NUM_GLYPH_MAPPINGS * sizeof(GlyphIndexingData));
 
     // size required by bitmap
     uint32_t const BITMAP_BYTES = BITMAP_WIDTH * BITMAP_HEIGHT * BYTES_PER_CHANNEL * NUM_CHANNELS;
@@ -259,9 +888,22 @@ namespace dash_tools
     // bytes required for kerning pairs
     uint32_t const KERN_PAIR_BYTES = static_cast<uint32_t>(sizeof(PerKernPair) * unpackedFontData.kernPairs.size());
 
+    // Number of mip levels
+    uint32_t const NUM_MIP_LEVELS = static_cast<uint32_t>(unpackedFontData.mipLevels.size());
+
+    // bytes required for the mip levels, each one stores its size in bytes, width and height before its data
+    uint32_t mipLevelBytes = 0;
+    for (auto const& MIP_LEVEL : unpackedFontData.mipLevels)
+      mipLevelBytes += sizeof(uint32_t) * 3 + MIP_LEVEL.width * MIP_LEVEL.height * BYTES_PER_CHANNEL * NUM_CHANNELS;
+
+    // Width of the distance range in texels
+    float const PIXEL_RANGE = unpackedFontData.pixelRange;
+
 
     // number of bytes required to store binary data
-    uint32_t const BYTES_REQUIRED = sizeof (NUM_GLYPHS) +        // number of glyphs
+    uint32_t const BYTES_REQUIRED = sizeof (uint32_t) +          // Tag marking separate glyph counts
+                                    sizeof (NUM_GLYPH_MAPPINGS) + // number of glyph mappings
+                                    sizeof (NUM_GLYPH_DATA) +     // number of glyph data entries
                                     GLYPH_MAPPING_BYTES +        // Bytes required to store GlyphIndex-uint32_t key value pairs
                                     GLYPHS_DATA_BYTES +          // Glyph data stored in matrix
                                     sizeof (BITMAP_BYTES) +      // Bytes required to store bitmap
@@ -269,15 +911,24 @@ namespace dash_tools
                                     sizeof (BITMAP_HEIGHT) +     // Height of bitmap
                                     BITMAP_BYTES +               // Actual bitmap data
                                     sizeof(NUM_KERN_PAIRS) +     // Number of unique kern pairs
-                                    KERN_PAIR_BYTES;             // Bytes required for Kerning pairs
+                                    KERN_PAIR_BYTES +            // Bytes required for Kerning pairs
+                                    sizeof(NUM_MIP_LEVELS) +     // Number of mip levels
+                                    mipLevelBytes +              // Bytes required for mip levels
+                                    sizeof(PIXEL_RANGE);         // Distance range in texels
 
     std::vector<uint8_t> toFileData{};
     uint32_t memoryCursor = 0;
     toFileData.resize(BYTES_REQUIRED);
 
-    // Write number of glyphs
-    std::memcpy (toFileData.data() + memoryCursor, &NUM_GLYPHS, sizeof(NUM_GLYPHS));
-    memoryCursor += sizeof(NUM_GLYPHS);
+    // Write the tag followed by the number of glyph mappings and glyph data entries
+    std::memcpy (toFileData.data() + memoryCursor, &FONT_SEPARATE_GLYPH_COUNTS_TAG, sizeof(FONT_SEPARATE_GLYPH_COUNTS_TAG));
+    memoryCursor += sizeof(FONT_SEPARATE_GLYPH_COUNTS_TAG);
+
+    std::memcpy (toFileData.data() + memoryCursor, &NUM_GLYPH_MAPPINGS, sizeof(NUM_GLYPH_MAPPINGS));
+    memoryCursor += sizeof(NUM_GLYPH_MAPPINGS);
+
+    std::memcpy (toFileData.data() + memoryCursor, &NUM_GLYPH_DATA, sizeof(NUM_GLYPH_DATA));
+    memoryCursor += sizeof(NUM_GLYPH_DATA);
 
     // write the glyph indexing data
     for (auto const& [GLYPH, INDEX] : unpackedFontData.glyphMappings)
@@ -320,6 +971,32 @@ namespace dash_tools
       std::memcpy(toFileData.data() + memoryCursor, &PER_KERN_PAIR, sizeof(PerKernPair));
       memoryCursor += sizeof(PerKernPair);
     }
+
+    // Number of mip levels. Written after the kerning pairs so files without mips can still be read.
+    std::memcpy(toFileData.data() + memoryCursor, &NUM_MIP_LEVELS, sizeof(NUM_MIP_LEVELS));
+    memoryCursor += sizeof(NUM_MIP_LEVELS);
+
+    // Write each mip level from largest to smallest
+    for (auto const& MIP_LEVEL : unpackedFontData.mipLevels)
+    {
+      uint32_t const MIP_BYTES = MIP_LEVEL.width * MIP_LEVEL.height * BYTES_PER_CHANNEL * NUM_CHANNELS;
+
+      std::memcpy(toFileData.data() + memoryCursor, &MIP_BYTES, sizeof(MIP_BYTES));
+      memoryCursor += sizeof(MIP_BYTES);
+
+      std::memcpy(toFileData.data() + memoryCursor, &MIP_LEVEL.width, sizeof(MIP_LEVEL.width));
+      memoryCursor += sizeof(MIP_LEVEL.width);
+
+      std::memcpy(toFileData.data() + memoryCursor, &MIP_LEVEL.height, sizeof(MIP_LEVEL.height));
+      memoryCursor += sizeof(MIP_LEVEL.height);
+
+      std::memcpy(toFileData.data() + memoryCursor, MIP_LEVEL.bitmap.data(), MIP_BYTES);
+      memoryCursor += MIP_BYTES;
+    }
+
+    // Pixel range the bitmap was generated with. Written last so files without it can still be read.
+    std::memcpy(toFileData.data() + memoryCursor, &PIXEL_RANGE, sizeof(PIXEL_RANGE));
+    memoryCursor += sizeof(PIXEL_RANGE);
     
     // Open a file for writing
     std::ofstream file{ newPath, std::ios::binary | std::ios::out | std::ios::trunc };
@@ -7,17 +7,56 @@
 
 namespace dash_tools
 {
+  // Generator every atlas is rendered with
+  using FontAtlasGenerator = msdf_atlas::ImmediateAtlasGenerator<float, 4, msdf_atlas::mtsdfGenerator, msdf_atlas::BitmapAtlasStorage<msdf_atlas::byte, 4>>;
+
+  struct FontAtlasParameters
+  {
+    // Smallest number of atlas pixels per em. The packer grows it to fill the atlas dimensions.
+    double minimumScale = 64.0;
+
+    // Width of the distance field around each edge in atlas pixels
+    double pixelRange = DEFAULT_FONT_PIXEL_RANGE;
+
+    msdf_atlas::TightAtlasPacker::DimensionsConstraint dimensionsConstraint = msdf_atlas::TightAtlasPacker::DimensionsConstraint::SQUARE;
+  };
+
+  struct FontAtlasBudget
+  {
+    // Maximum size of the atlas including its mip chain
+    uint32_t maxBytes;
+
+    // Maximum reconstruction error, see FontAtlasTuner::MeasureReconstructionError
+    double maxError;
+  };
+
   class FontCompiler
   {
   private:
     static void GenerateUnpackedFontData(UnpackedFontData&                             fontAsset, 
                                          std::vector<msdf_atlas::GlyphGeometry> const& glyphData, 
+                                         std::vector<msdf_atlas::GlyphGeometry> const& uniqueGlyphData, 
+                                         std::vector<uint32_t> const&                  uniqueGlyphIndices, 
                                          msdf_atlas::FontGeometry const&               fontGeometry) noexcept;
+
+    static std::vector<uint32_t> DeduplicateGlyphs  (std::vector<msdf_atlas::GlyphGeometry> const& glyphData, 
+                                                     std::vector<msdf_atlas::GlyphGeometry>&       uniqueGlyphData) noexcept;
+    static uint64_t              HashGlyphShape     (msdfgen::Shape const& shape, std::vector<double>& shapeSignature) noexcept;
+  	
+    static uint32_t            MeasureAtlasBytes    (msdfgen::FontHandle* fontHandle, msdf_atlas::Charset const& charset, FontAtlasParameters const& parameters) noexcept;
+    static msdf_atlas::Charset LoadFontCharset      (msdfgen::FontHandle* fontHandle) noexcept;
+    static uint64_t            HashCharset          (msdf_atlas::Charset const& charset) noexcept;
+    static bool                IsSubsetUpToDate     (AssetPath const& path, uint64_t charsetHash) noexcept;
   	
   public:
-    static std::optional<AssetPath> LoadAndCompileFont   (msdfgen::FreetypeHandle* freetypeHandle, AssetPath path) noexcept;
-    static UnpackedFontData const*  CompileFontToMemory  (msdfgen::FontHandle* fontHandle, AssetPath path) noexcept;
-    static std::string              PackFontDataToFile  (AssetPath path, UnpackedFontData const& unpackedFontData) noexcept;
+    static std::optional<AssetPath>           LoadAndCompileFont       (msdfgen::FreetypeHandle* freetypeHandle, AssetPath path, std::optional<FontAtlasBudget> const& budget = {}) noexcept;
+    static std::optional<AssetPath>           LoadAndCompileFontSubset (msdfgen::FreetypeHandle* freetypeHandle, AssetPath path, msdf_atlas::Charset const& charset, std::optional<FontAtlasBudget> const& budget = {}) noexcept;
+    static std::optional<msdf_atlas::Charset> LoadCorpusCharset        (std::vector<AssetPath> const& corpusPaths) noexcept;
+    static UnpackedFontData const*            CompileFontToMemory      (msdfgen::FontHandle* fontHandle, AssetPath path, msdf_atlas::Charset const& charset = msdf_atlas::Charset::ASCII, std::optional<FontAtlasBudget> const& budget = {}, FontAtlasParameters* usedParameters = nullptr) noexcept;
+    static std::string                        PackFontDataToFile       (AssetPath path, UnpackedFontData const& unpackedFontData) noexcept;
+    static void                               ConfigureAtlasPacker     (msdf_atlas::TightAtlasPacker& atlasPacker, FontAtlasParameters const& parameters = {}) noexcept;
+    static void                               GenerateGlyphBitmap      (msdfgen::Shape const& shape, msdfgen::Projection const& projection, double range, 
+                                                                        uint32_t width, uint32_t height, uint8_t* dst, uint32_t dstStride) noexcept;
     
   };
 }
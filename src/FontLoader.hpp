@@ -3,6 +3,7 @@
 #include "Font.hpp"
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 
 namespace dash_tools
 {
@@ -14,7 +15,7 @@ namespace dash_tools
       std::is_same_v<PointerType, Font*> ||
       std::is_same_v<PointerType, std::shared_ptr<Font>> || 
       std::is_same_v<PointerType, std::unique_ptr<Font>>>>
-      static PointerType ReadAndUnpackFileData(AssetPath path) noexcept
+      static PointerType ReadAndUnpackFileData(AssetPath path, uint32_t firstMipLevel = 0) noexcept
     {
       std::ifstream ifs{ path.c_str(), std::ios::binary };
 
@@ -30,7 +31,7 @@ namespace dash_tools
         ifs.read(reinterpret_cast<char*>(binaryData.data()), FILE_SIZE);
 
         // Proceed to read contents chunk by chunk and save it into new font object.
-        auto newFont = unpackFontBinary<PointerType>(binaryData);
+        auto newFont = unpackFontBinary<PointerType>(binaryData, firstMipLevel);
 
         // Return the new font object
         if constexpr (std::is_same_v<PointerType, Font*>)
@@ -50,7 +51,7 @@ namespace dash_tools
       std::is_same_v<PointerType, Font*> ||
       std::is_same_v<PointerType, std::shared_ptr<Font>> ||
       std::is_same_v<PointerType, std::unique_ptr<Font>>>>
-      static PointerType unpackFontBinary(std::vector<uint8_t> const& binaryData) noexcept
+      static PointerType unpackFontBinary(std::vector<uint8_t> const& binaryData, uint32_t firstMipLevel) noexcept
     {
       // Prepare object to initialize font object
       UnpackedFontData unpackedFontData{};
@@ -61,13 +62,23 @@ namespace dash_tools
         // For traversing the binary data
         uint32_t memoryCursor{ 0 };
 
-        // Get number of glyphs available
-        uint32_t numGlyphs{ 0 };
-        std::memcpy(&numGlyphs, binaryData.data() + memoryCursor, sizeof(numGlyphs));
-        memoryCursor += sizeof(numGlyphs);
+        // Get number of glyph mappings and glyph data entries. Older files store a single count used for both
+        uint32_t numGlyphMappings{ 0 };
+        std::memcpy(&numGlyphMappings, binaryData.data() + memoryCursor, sizeof(numGlyphMappings));
+        memoryCursor += sizeof(numGlyphMappings);
+
+        uint32_t numGlyphData{ numGlyphMappings };
+        if (numGlyphMappings == FONT_SEPARATE_GLYPH_COUNTS_TAG)
+        {
+          std::memcpy(&numGlyphMappings, binaryData.data() + memoryCursor, sizeof(numGlyphMappings));
+          memoryCursor += sizeof(numGlyphMappings);
+
+          std::memcpy(&numGlyphData, binaryData.data() + memoryCursor, sizeof(numGlyphData));
+          memoryCursor += sizeof(numGlyphData);
+        }
 
         // Get glyph indexing data 
-        for (uint32_t i = 0; i < numGlyphs; ++i)
+        for (uint32_t i = 0; i < numGlyphMappings; ++i)
         {
           GlyphIndexingData indexingData{};
           std::memcpy(&indexingData, binaryData.data() + memoryCursor, sizeof(GlyphIndexingData));
@@ -77,8 +88,8 @@ namespace dash_tools
         }
 
         // Get glyph data (since it's all stored contiguously, 1 single memcpy will suffice)
-        uint32_t const GLYPH_DATA_BYTES = sizeof(GlyphData) * numGlyphs;
-        unpackedFontData.glyphData.resize(numGlyphs);
+        uint32_t const GLYPH_DATA_BYTES = sizeof(GlyphData) * numGlyphData;
+        unpackedFontData.glyphData.resize(numGlyphData);
         std::memcpy(unpackedFontData.glyphData.data(), binaryData.data() + memoryCursor, GLYPH_DATA_BYTES);
         memoryCursor += GLYPH_DATA_BYTES;
 
@@ -93,9 +104,8 @@ namespace dash_tools
         std::memcpy(&unpackedFontData.bitmapHeight, binaryData.data() + memoryCursor, sizeof(unpackedFontData.bitmapHeight));
         memoryCursor += sizeof(unpackedFontData.bitmapHeight);
 
-        // Get the actual bitmap data
-        unpackedFontData.fontBitmap.resize(bitmapBytes);
-        std::memcpy(unpackedFontData.fontBitmap.data(), binaryData.data() + memoryCursor, bitmapBytes);
+        // Bitmap data is only copied once we know which level becomes the base level
+        uint32_t const BITMAP_CURSOR = memoryCursor;
         memoryCursor += bitmapBytes;
 
         // Get number of kern pairs
@@ -111,6 +121,64 @@ namespace dash_tools
           unpackedFontData.kernPairs.emplace(std::pair{ kernPairData.lhs, kernPairData.rhs }, kernPairData.kerning);
           memoryCursor += sizeof(PerKernPair);
         }
+
+        // Get number of mip levels. Files compiled before mips were added end here.
+        uint32_t numMipLevels{ 0 };
+        if (memoryCursor + sizeof(numMipLevels) <= binaryData.size())
+        {
+          std::memcpy(&numMipLevels, binaryData.data() + memoryCursor, sizeof(numMipLevels));
+          memoryCursor += sizeof(numMipLevels);
+        }
+
+        // Can't skip more levels than the file has
+        firstMipLevel = std::min(firstMipLevel, numMipLevels);
+
+        // Get the actual bitmap data if it is the first level loaded
+        if (firstMipLevel == 0)
+        {
+          unpackedFontData.fontBitmap.resize(bitmapBytes / sizeof(BitmapPixelType));
+          std::memcpy(unpackedFontData.fontBitmap.data(), binaryData.data() + BITMAP_CURSOR, bitmapBytes);
+        }
+
+        // Get the mip levels. Levels above firstMipLevel are skipped and the first level loaded replaces the bitmap.
+        for (uint32_t i = 1; i <= numMipLevels; ++i)
+        {
+          FontBitmapLevel mipLevel{};
+
+          uint32_t mipBytes{};
+          std::memcpy(&mipBytes, binaryData.data() + memoryCursor, sizeof(mipBytes));
+          memoryCursor += sizeof(mipBytes);
+
+          std::memcpy(&mipLevel.width, binaryData.data() + memoryCursor, sizeof(mipLevel.width));
+          memoryCursor += sizeof(mipLevel.width);
+          std::memcpy(&mipLevel.height, binaryData.data() + memoryCursor, sizeof(mipLevel.height));
+          memoryCursor += sizeof(mipLevel.height);
+
+          if (i >= firstMipLevel)
+          {
+            mipLevel.bitmap.resize(mipBytes / sizeof(BitmapPixelType));
+            std::memcpy(mipLevel.bitmap.data(), binaryData.data() + memoryCursor, mipBytes);
+
+            if (i == firstMipLevel)
+            {
+              unpackedFontData.fontBitmap = std::move(mipLevel.bitmap);
+              unpackedFontData.bitmapWidth = mipLevel.width;
+              unpackedFontData.bitmapHeight = mipLevel.height;
+            }
+            else
+              unpackedFontData.mipLevels.push_back(std::move(mipLevel));
+          }
+
+          memoryCursor += mipBytes;
+        }
+
+        // Get the pixel range. Files compiled before it was stored all used the default.
+        unpackedFontData.pixelRange = DEFAULT_FONT_PIXEL_RANGE;
+        if (memoryCursor + sizeof(unpackedFontData.pixelRange) <= binaryData.size())
+        {
+          std::memcpy(&unpackedFontData.pixelRange, binaryData.data() + memoryCursor, sizeof(unpackedFontData.pixelRange));
+          memoryCursor += sizeof(unpackedFontData.pixelRange);
+        }
       }
 
       
@@ -0,0 +1,169 @@
+#include "FontMipmapper.hpp"
+#include "FontCompiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace dash_tools
+{
+  /***************************************************************************/
+  /*!
+
+    \brief
+      Generates the smaller levels of the font bitmap and stores them in the
+      mip levels of the unpacked font data. 
+      
+      Averaging distance field texels is wrong at the corners of an MSDF 
+      (the median of averages is not the average of medians) and halves the
+      range in texels every level, so each level is generated from the glyph
+      outlines instead. Every glyph is rendered at the level's resolution 
+      into the same normalized box as in the full size bitmap, with the same
+      distance range in texels. Glyph uv data stays valid and a level can be 
+      used as the full size bitmap of a smaller font.
+
+      The packer keeps FONT_MIP_GLYPH_SPACING pixels between glyph boxes, so
+      boxes never share a texel on any level.
+
+    \param unpackedFontData
+      Font data with a valid bitmap. Any existing mip levels are replaced.
+
+    \param glyphData
+      Glyphs packed into the bitmap.
+
+  */
+  /***************************************************************************/
+  void FontMipmapper::GenerateMipChain(UnpackedFontData& unpackedFontData, std::vector<msdf_atlas::GlyphGeometry> const& glyphData) noexcept
+  {
+    // Same number of threads the atlas is generated with
+    static constexpr uint32_t NUM_THREADS = 4;
+
+    unpackedFontData.mipLevels.clear();
+
+    uint32_t const BITMAP_WIDTH = unpackedFontData.bitmapWidth;
+    uint32_t const BITMAP_HEIGHT = unpackedFontData.bitmapHeight;
+    uint32_t const NUM_MIP_LEVELS = GetNumMipLevels(BITMAP_WIDTH, BITMAP_HEIGHT);
+
+    for (uint32_t level = 1; level <= NUM_MIP_LEVELS; ++level)
+    {
+      FontBitmapLevel mipLevel{};
+      mipLevel.width = BITMAP_WIDTH >> level;
+      mipLevel.height = BITMAP_HEIGHT >> level;
+      mipLevel.bitmap.resize(static_cast<size_t>(mipLevel.width) * mipLevel.height);
+
+      // Exact ratio between this level and the full size bitmap so normalized coordinates match even for odd sizes
+      double const RATIO_X = static_cast<double>(mipLevel.width) / BITMAP_WIDTH;
+      double const RATIO_Y = static_cast<double>(mipLevel.height) / BITMAP_HEIGHT;
+
+      auto const GENERATE_GLYPHS = [&](size_t first, size_t last)
+      {
+        for (size_t i = first; i < last; ++i)
+        {
+          msdf_atlas::GlyphGeometry const& glyph = glyphData[i];
+          if (glyph.isWhitespace())
+            continue;
+
+          int boxX = 0, boxY = 0, boxW = 0, boxH = 0;
+          glyph.getBoxRect(boxX, boxY, boxW, boxH);
+          if (boxW <= 0 || boxH <= 0)
+            continue;
+
+          // Texels of this level the box covers
+          int const LEVEL_X0 = static_cast<int>(std::floor(boxX * RATIO_X));
+          int const LEVEL_Y0 = static_cast<int>(std::floor(boxY * RATIO_Y));
+          int const LEVEL_X1 = std::min(static_cast<int>(std::ceil((boxX + boxW) * RATIO_X)), static_cast<int>(mipLevel.width));
+          int const LEVEL_Y1 = std::min(static_cast<int>(std::ceil((boxY + boxH) * RATIO_Y)), static_cast<int>(mipLevel.height));
+          if (LEVEL_X1 <= LEVEL_X0 || LEVEL_Y1 <= LEVEL_Y0)
+            continue;
+
+          // Box projection is pixel = scale * (shape + translate). Scale it down to this level and move the origin to the first covered texel.
+          double const BOX_SCALE = glyph.getBoxScale();
+          msdfgen::Vector2 const BOX_TRANSLATE = glyph.getBoxTranslate();
+          msdfgen::Projection const PROJECTION
+          {
+            msdfgen::Vector2{ BOX_SCALE * RATIO_X, BOX_SCALE * RATIO_Y },
+            msdfgen::Vector2{ BOX_TRANSLATE.x + (boxX - LEVEL_X0 / RATIO_X) / BOX_SCALE, BOX_TRANSLATE.y + (boxY - LEVEL_Y0 / RATIO_Y) / BOX_SCALE },
+          };
+
+          // Same range in texels means a wider range in shape units
+          double const RANGE = glyph.getBoxRange() / std::min(RATIO_X, RATIO_Y);
+
+          uint8_t* dst = reinterpret_cast<uint8_t*>(mipLevel.bitmap.data() + static_cast<size_t>(LEVEL_Y0) * mipLevel.width + LEVEL_X0);
+          FontCompiler::GenerateGlyphBitmap(glyph.getShape(), PROJECTION, RANGE, LEVEL_X1 - LEVEL_X0, LEVEL_Y1 - LEVEL_Y0, dst, mipLevel.width);
+        }
+      };
+
+      // Glyph boxes never overlap so each thread can write its glyphs directly into the level
+      std::vector<std::thread> threads;
+      size_t const GLYPHS_PER_THREAD = (glyphData.size() + NUM_THREADS - 1) / NUM_THREADS;
+      for (size_t first = 0; first < glyphData.size(); first += GLYPHS_PER_THREAD)
+        threads.emplace_back(GENERATE_GLYPHS, first, std::min(first + GLYPHS_PER_THREAD, glyphData.size()));
+
+      for (std::thread& thread : threads)
+        thread.join();
+
+      unpackedFontData.mipLevels.push_back(std::move(mipLevel));
+    }
+  }
+
+  /***************************************************************************/
+  /*!
+
+    \brief
+      Number of levels GenerateMipChain generates for a bitmap. Generation 
+      stops when the next level would be smaller than FONT_MIN_MIP_DIMENSION
+      or when FONT_MAX_MIP_LEVELS is reached.
+
+    \param width
+      Width of the full size bitmap.
+
+    \param height
+      Height of the full size bitmap.
+
+    \return
+      Number of mip levels.
+
+  */
+  /***************************************************************************/
+  uint32_t FontMipmapper::GetNumMipLevels(uint32_t width, uint32_t height) noexcept
+  {
+    uint32_t numLevels = 0;
+
+    while (numLevels < FONT_MAX_MIP_LEVELS && 
+           (width >> (numLevels + 1)) >= FONT_MIN_MIP_DIMENSION && 
+           (height >> (numLevels + 1)) >= FONT_MIN_MIP_DIMENSION)
+      ++numLevels;
+
+    return numLevels;
+  }
+
+  /***************************************************************************/
+  /*!
+
+    \brief
+      Computes the bytes GenerateMipChain would add for a bitmap without
+      generating anything.
+
+    \param width
+      Width of the full size bitmap.
+
+    \param height
+      Height of the full size bitmap.
+
+    \return
+      Total size of the mip levels in bytes.
+
+  */
+  /***************************************************************************/
+  uint32_t FontMipmapper::GetMipChainBytes(uint32_t width, uint32_t height) noexcept
+  {
+    uint32_t mipBytes = 0;
+
+    uint32_t const NUM_MIP_LEVELS = GetNumMipLevels(width, height);
+    for (uint32_t level = 1; level <= NUM_MIP_LEVELS; ++level)
+      mipBytes += (width >> level) * (height >> level) * BYTES_PER_CHANNEL * NUM_CHANNELS;
+
+    return mipBytes;
+  }
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include "msdf-atlas-gen/msdf-atlas-gen.h"
+#include "FontCommonTypes.hpp"
+
+namespace dash_tools
+{
+  // Builds the mip chain of a font bitmap at compile time.
+  // Levels are regenerated from the glyph outlines rather than downsampled with a SIMD filter, since filtering 
+  // MSDF texels corrupts corners and halves the distance range every level. SIMD is only used when converting 
+  // the generated distances to bytes in FontCompiler::GenerateGlyphBitmap.
+  class FontMipmapper
+  {
+  public:
+    static void     GenerateMipChain (UnpackedFontData& unpackedFontData, std::vector<msdf_atlas::GlyphGeometry> const& glyphData) noexcept;
+    static uint32_t GetNumMipLevels  (uint32_t width, uint32_t height) noexcept;
+    static uint32_t GetMipChainBytes (uint32_t width, uint32_t height) noexcept;
+
+  };
+}
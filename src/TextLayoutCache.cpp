@@ -0,0 +1,377 @@
+#include "TextLayoutCache.hpp"
+#include "Utf8.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace dash_tools
+{
+  size_t TextLayoutKeyHash::operator()(TextLayoutKey const& key) const noexcept
+  {
+    // Mix the remaining fields into the string hash
+    uint64_t hash = key.stringHash;
+    auto const COMBINE = [&hash](uint64_t value)
+    {
+      hash ^= value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+    };
+
+    uint32_t sizeBits = 0, wrapBits = 0;
+    std::memcpy(&sizeBits, &key.size, sizeof(sizeBits));
+    std::memcpy(&wrapBits, &key.wrapWidth, sizeof(wrapBits));
+
+    COMBINE(reinterpret_cast<uintptr_t>(key.font));
+    COMBINE(key.stringLength);
+    COMBINE(sizeBits);
+    COMBINE(wrapBits);
+
+    return static_cast<size_t>(hash);
+  }
+
+  TextLayoutCache::TextLayoutCache(uint32_t maxUnusedFrames) noexcept
+    : m_entries{}
+    , m_arenaBlocks{}
+    , m_currentBlock{ 0 }
+    , m_blockCursor{ 0 }
+    , m_scratchQuads{}
+    , m_currentFrame{ 0 }
+    , m_maxUnusedFrames{ maxUnusedFrames }
+    , m_stats{}
+  {
+
+  }
+
+  /***************************************************************************/
+  /*!
+
+    \brief
+      Returns the quads for a string, laying it out only if the same string
+      was not requested with the same font, size and wrap width recently.
+      Entries are found by the hash of the string but the string itself is
+      compared before a layout is returned.
+      
+      The returned quads stay valid until the next call to BeginFrame or 
+      Clear.
+
+    \param font
+      Font to lay the text out with.
+
+    \param text
+      UTF-8 encoded text.
+
+    \param size
+      Size of 1 em.
+
+    \param wrapWidth
+      Lines are wrapped at spaces once they get wider than this. 0 disables
+      wrapping.
+
+    \return
+      The laid out quads.
+
+  */
+  /***************************************************************************/
+  std::span<GlyphQuad const> TextLayoutCache::GetLayout(Font const& font, std::string_view text, float size, float wrapWidth) noexcept
+  {
+    TextLayoutKey const KEY{ &font, HashString(text), static_cast<uint32_t>(text.size()), size, wrapWidth };
+
+    auto it = m_entries.find(KEY);
+    if (it != m_entries.end() && it->second.text == text)
+    {
+      ++m_stats.hits;
+      it->second.lastUsedFrame = m_currentFrame;
+
+      if (it->second.count == 0)
+        return {};
+
+      return { m_arenaBlocks[it->second.block].quads.get() + it->second.offset, it->second.count };
+    }
+
+    ++m_stats.misses;
+
+    // Lay out into scratch first since we don't know the number of quads yet
+    LayoutText(font, text, size, wrapWidth, m_scratchQuads);
+
+    CacheEntry newEntry{ 0, 0, static_cast<uint32_t>(m_scratchQuads.size()), m_currentFrame, std::string{ text } };
+
+    GlyphQuad* quads = nullptr;
+    if (newEntry.count > 0)
+    {
+      quads = allocateQuads(newEntry.count, newEntry.block, newEntry.offset);
+      std::copy(m_scratchQuads.begin(), m_scratchQuads.end(), quads);
+    }
+
+    uint32_t const COUNT = newEntry.count;
+
+    // A different string with the same hash replaces the old layout. Its quads stay in the arena until it is compacted.
+    m_entries.insert_or_assign(KEY, std::move(newEntry));
+
+    return { quads, COUNT };
+  }
+
+  /***************************************************************************/
+  /*!
+
+    \brief
+      Advances the frame counter and evicts every layout that has not been
+      requested for the maximum number of unused frames. The arena is 
+      compacted if anything was evicted, which invalidates all quads 
+      previously returned.
+
+  */
+  /***************************************************************************/
+  void TextLayoutCache::BeginFrame(void) noexcept
+  {
+    ++m_currentFrame;
+
+    uint64_t const NUM_EVICTIONS = std::erase_if(m_entries, [this](auto const& entry)
+    {
+      return m_currentFrame - entry.second.lastUsedFrame > m_maxUnusedFrames;
+    });
+
+    if (NUM_EVICTIONS > 0)
+    {
+      m_stats.evictions += NUM_EVICTIONS;
+      compactArena();
+    }
+  }
+
+  /***************************************************************************/
+  /*!
+
+    \brief
+      Removes every layout. Arena blocks are kept for reuse.
+
+  */
+  /***************************************************************************/
+  void TextLayoutCache::Clear(void) noexcept
+  {
+    m_stats.evictions += m_entries.size();
+    m_entries.clear();
+    m_currentBlock = 0;
+    m_blockCursor = 0;
+  }
+
+  /***************************************************************************/
+  /*!
+
+    \brief
+      Lays out a string without caching it. Glyphs missing from the font are
+      skipped and glyphs without an outline (i.e. whitespace) only advance
+      the pen. Each line is 1 em below the previous one.
+
+    \param font
+      Font to lay the text out with.
+
+    \param text
+      UTF-8 encoded text.
+
+    \param size
+      Size of 1 em.
+
+    \param wrapWidth
+      Lines are wrapped at spaces once they get wider than this. 0 disables
+      wrapping.
+
+    \param quads
+      Container the quads are written to. Existing contents are discarded.
+
+  */
+  /***************************************************************************/
+  void TextLayoutCache::LayoutText(Font const& font, std::string_view text, float size, float wrapWidth, std::vector<GlyphQuad>& quads) noexcept
+  {
+    quads.clear();
+
+    auto const& GLYPH_MAPPINGS = font.GetGlyphMappings();
+    auto const& GLYPH_DATA = font.GetGlyphData();
+
+    // Position of the current glyph on its baseline
+    float penX = 0.0f, penY = 0.0f;
+
+    // The first quad after the last space on the current line and where the pen was after that space
+    std::optional<size_t> breakQuad{};
+    float breakX = 0.0f;
+
+    size_t cursor = 0;
+    std::optional<GlyphType> glyph{};
+    if (!text.empty())
+      glyph = DecodeUtf8(text, cursor);
+
+    while (glyph)
+    {
+      // Next glyph is needed for kerning
+      std::optional<GlyphType> nextGlyph{};
+      if (cursor < text.size())
+        nextGlyph = DecodeUtf8(text, cursor);
+
+      if (*glyph == '\n')
+      {
+        penX = 0.0f;
+        penY -= size;
+        breakQuad.reset();
+      }
+      else if (auto it = GLYPH_MAPPINGS.find(*glyph); it != GLYPH_MAPPINGS.end())
+      {
+        float const* DATA = GLYPH_DATA[it->second].data;
+
+        GlyphQuad quad
+        {
+          { penX + DATA[GLYPH_POS_X_ARRAY_INDEX] * size, penY + DATA[GLYPH_POS_Y_ARRAY_INDEX] * size },
+          { DATA[GLYPH_SCALE_X_ARRAY_INDEX] * size,      DATA[GLYPH_SCALE_Y_ARRAY_INDEX] * size      },
+          { DATA[GLYPH_TEX_POS_X_ARRAY_INDEX],           DATA[GLYPH_TEX_POS_Y_ARRAY_INDEX]           },
+          { DATA[GLYPH_TEX_DIMS_X_ARRAY_INDEX],          DATA[GLYPH_TEX_DIMS_Y_ARRAY_INDEX]          },
+        };
+
+        if (quad.scale[0] > 0.0f && quad.scale[1] > 0.0f)
+        {
+          // Move the word being typed to the next line if it doesn't fit
+          if (wrapWidth > 0.0f && breakQuad && quad.position[0] + quad.scale[0] > wrapWidth)
+          {
+            for (size_t i = *breakQuad; i < quads.size(); ++i)
+            {
+              quads[i].position[0] -= breakX;
+              quads[i].position[1] -= size;
+            }
+
+            quad.position[0] -= breakX;
+            quad.position[1] -= size;
+            penX -= breakX;
+            penY -= size;
+            breakQuad.reset();
+          }
+
+          quads.push_back(quad);
+        }
+
+        penX += font.GetKerning(*glyph, nextGlyph.value_or(0)).value_or(0.0f) * size;
+
+        if (*glyph == ' ')
+        {
+          breakQuad = quads.size();
+          breakX = penX;
+        }
+      }
+
+      glyph = nextGlyph;
+    }
+  }
+
+  /***************************************************************************/
+  /*!
+
+    \brief
+      64 bit FNV-1a hash of a string.
+
+    \param text
+      String to hash.
+
+    \return
+      The hash.
+
+  */
+  /***************************************************************************/
+  uint64_t TextLayoutCache::HashString(std::string_view text) noexcept
+  {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (char const CHARACTER : text)
+    {
+      hash ^= static_cast<uint8_t>(CHARACTER);
+      hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+  }
+
+  TextLayoutCacheStats const& TextLayoutCache::GetStats(void) const noexcept
+  {
+    return m_stats;
+  }
+
+  uint32_t TextLayoutCache::GetNumEntries(void) const noexcept
+  {
+    return static_cast<uint32_t>(m_entries.size());
+  }
+
+  void TextLayoutCache::ResetStats(void) noexcept
+  {
+    m_stats = {};
+  }
+
+  /***************************************************************************/
+  /*!
+
+    \brief
+      Bump allocates quads from the arena. A new block is only created when
+      none of the remaining blocks have enough space.
+
+    \param count
+      Number of quads to allocate.
+
+    \param block
+      Set to the index of the block the quads are in.
+
+    \param offset
+      Set to the index of the first quad in the block.
+
+    \return
+      Pointer to the first quad.
+
+  */
+  /***************************************************************************/
+  GlyphQuad* TextLayoutCache::allocateQuads(uint32_t count, uint32_t& block, uint32_t& offset) noexcept
+  {
+    while (m_currentBlock < m_arenaBlocks.size() && m_blockCursor + count > m_arenaBlocks[m_currentBlock].capacity)
+    {
+      ++m_currentBlock;
+      m_blockCursor = 0;
+    }
+
+    if (m_currentBlock == m_arenaBlocks.size())
+    {
+      // Strings longer than a block get a block of their own
+      uint32_t const CAPACITY = std::max(count, ARENA_BLOCK_QUADS);
+      m_arenaBlocks.push_back(ArenaBlock{ std::unique_ptr<GlyphQuad[]>(new GlyphQuad[CAPACITY]), CAPACITY });
+    }
+
+    block = m_currentBlock;
+    offset = m_blockCursor;
+    m_blockCursor += count;
+
+    return m_arenaBlocks[block].quads.get() + offset;
+  }
+
+  /***************************************************************************/
+  /*!
+
+    \brief
+      Packs the quads of the remaining layouts to the front of the arena so
+      the space of evicted layouts can be reused.
+
+  */
+  /***************************************************************************/
+  void TextLayoutCache::compactArena(void) noexcept
+  {
+    // Copy everything out first since layouts may move within the same block
+    m_scratchQuads.clear();
+    for (auto& [KEY, entry] : m_entries)
+    {
+      GlyphQuad const* QUADS = m_arenaBlocks[entry.block].quads.get() + entry.offset;
+      uint32_t const SCRATCH_OFFSET = static_cast<uint32_t>(m_scratchQuads.size());
+      m_scratchQuads.insert(m_scratchQuads.end(), QUADS, QUADS + entry.count);
+      entry.offset = SCRATCH_OFFSET;
+    }
+
+    m_currentBlock = 0;
+    m_blockCursor = 0;
+
+    for (auto& [KEY, entry] : m_entries)
+    {
+      if (entry.count == 0)
+        continue;
+
+      uint32_t const SCRATCH_OFFSET = entry.offset;
+      GlyphQuad* quads = allocateQuads(entry.count, entry.block, entry.offset);
+      std::copy_n(m_scratchQuads.begin() + SCRATCH_OFFSET, entry.count, quads);
+    }
+  }
+
+}
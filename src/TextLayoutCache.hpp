@@ -0,0 +1,126 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "Font.hpp"
+
+namespace dash_tools
+{
+  struct TextLayoutKey
+  {
+    Font const* font;
+    uint64_t    stringHash;
+    uint32_t    stringLength;
+    float       size;
+    float       wrapWidth;
+
+    bool operator== (TextLayoutKey const& rhs) const noexcept = default;
+  };
+
+  struct TextLayoutKeyHash
+  {
+    size_t operator() (TextLayoutKey const& key) const noexcept;
+  };
+
+  struct TextLayoutCacheStats
+  {
+    // Number of layouts returned from the cache
+    uint64_t hits;
+
+    // Number of layouts that had to be computed
+    uint64_t misses;
+
+    // Number of layouts removed for not being used
+    uint64_t evictions;
+  };
+
+  class TextLayoutCache
+  {
+  public:
+    // Layouts not requested for this many frames are evicted
+    static constexpr uint32_t DEFAULT_MAX_UNUSED_FRAMES = 60;
+
+    // Number of quads in each block of the arena
+    static constexpr uint32_t ARENA_BLOCK_QUADS = 4096;
+
+    //*************************************************************************
+    // CONSTRUCTORS AND DESTRUCTORS
+    //*************************************************************************
+    TextLayoutCache (uint32_t maxUnusedFrames = DEFAULT_MAX_UNUSED_FRAMES) noexcept;
+
+    TextLayoutCache (TextLayoutCache const& rhs) = delete;
+    TextLayoutCache& operator=(TextLayoutCache const& rhs) = delete;
+
+    //*************************************************************************
+    // PUBLIC MEMBER FUNCTIONS
+    //*************************************************************************
+    std::span<GlyphQuad const> GetLayout  (Font const& font, std::string_view text, float size, float wrapWidth = 0.0f) noexcept;
+    void                       BeginFrame (void) noexcept;
+    void                       Clear      (void) noexcept;
+
+    static void     LayoutText (Font const& font, std::string_view text, float size, float wrapWidth, std::vector<GlyphQuad>& quads) noexcept;
+    static uint64_t HashString (std::string_view text) noexcept;
+
+    //*************************************************************************
+    // SETTERS AND GETTERS
+    //*************************************************************************
+    TextLayoutCacheStats const& GetStats       (void) const noexcept;
+    uint32_t                    GetNumEntries  (void) const noexcept;
+    void                        ResetStats     (void) noexcept;
+
+  private:
+    struct CacheEntry
+    {
+      // Position of the quads in the arena
+      uint32_t block;
+      uint32_t offset;
+      uint32_t count;
+
+      // Frame this layout was last requested on
+      uint64_t lastUsedFrame;
+
+      // Compared on every hit since different strings can share a hash
+      std::string text;
+    };
+
+    struct ArenaBlock
+    {
+      std::unique_ptr<GlyphQuad[]> quads;
+      uint32_t capacity;
+    };
+
+    //*************************************************************************
+    // PRIVATE MEMBER FUNCTIONS
+    //*************************************************************************
+    GlyphQuad* allocateQuads (uint32_t count, uint32_t& block, uint32_t& offset) noexcept;
+    void       compactArena  (void) noexcept;
+
+    //*************************************************************************
+    // PRIVATE MEMBER VARIABLES
+    //*************************************************************************
+    // Cached layouts
+    std::unordered_map<TextLayoutKey, CacheEntry, TextLayoutKeyHash> m_entries;
+
+    // Blocks are never freed, only reused after the arena is compacted
+    std::vector<ArenaBlock> m_arenaBlocks;
+
+    // Block currently being allocated from and the first free quad in it
+    uint32_t m_currentBlock;
+    uint32_t m_blockCursor;
+
+    // Reused so layouts and compaction don't allocate every time
+    std::vector<GlyphQuad> m_scratchQuads;
+
+    uint64_t m_currentFrame;
+    uint32_t m_maxUnusedFrames;
+
+    TextLayoutCacheStats m_stats;
+
+  };
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string_view>
+#include "FontCommonTypes.hpp"
+
+namespace dash_tools
+{
+  // Returned for malformed sequences
+  static constexpr GlyphType UTF8_REPLACEMENT_CHARACTER = 0xFFFD;
+
+  /***************************************************************************/
+  /*!
+
+    \brief
+      Decodes the UTF-8 sequence starting at cursor and moves the cursor past
+      it. Malformed sequences consume a single byte and return 
+      UTF8_REPLACEMENT_CHARACTER.
+
+    \param text
+      UTF-8 encoded text.
+
+    \param cursor
+      Byte offset into text. Must be less than the size of text.
+
+    \return
+      The decoded codepoint.
+
+  */
+  /***************************************************************************/
+  inline GlyphType DecodeUtf8(std::string_view text, size_t& cursor) noexcept
+  {
+    uint8_t const LEAD = static_cast<uint8_t>(text[cursor]);
+
+    // Number of continuation bytes and the bits the lead byte contributes
+    uint32_t numContinuations = 0;
+    uint32_t codepoint = 0;
+
+    if (LEAD < 0x80)
+    {
+      ++cursor;
+      return static_cast<GlyphType>(LEAD);
+    }
+    else if ((LEAD & 0xE0) == 0xC0)
+    {
+      numContinuations = 1;
+      codepoint = LEAD & 0x1F;
+    }
+    else if ((LEAD & 0xF0) == 0xE0)
+    {
+      numContinuations = 2;
+      codepoint = LEAD & 0x0F;
+    }
+    else if ((LEAD & 0xF8) == 0xF0)
+    {
+      numContinuations = 3;
+      codepoint = LEAD & 0x07;
+    }
+    else
+    {
+      ++cursor;
+      return UTF8_REPLACEMENT_CHARACTER;
+    }
+
+    // Truncated sequence at the end of the text
+    if (cursor + numContinuations >= text.size())
+    {
+      ++cursor;
+      return UTF8_REPLACEMENT_CHARACTER;
+    }
+
+    for (uint32_t i = 1; i <= numContinuations; ++i)
+    {
+      uint8_t const CONTINUATION = static_cast<uint8_t>(text[cursor + i]);
+      if ((CONTINUATION & 0xC0) != 0x80)
+      {
+        ++cursor;
+        return UTF8_REPLACEMENT_CHARACTER;
+      }
+
+      codepoint = (codepoint << 6) | (CONTINUATION & 0x3F);
+    }
+
+    cursor += numContinuations + 1;
+
+    // Overlong encodings, surrogates and values past the unicode range are not valid codepoints
+    static constexpr uint32_t MIN_CODEPOINT[4] = { 0x0, 0x80, 0x800, 0x10000 };
+    if (codepoint < MIN_CODEPOINT[numContinuations] || (codepoint >= 0xD800 && codepoint <= 0xDFFF) || codepoint > 0x10FFFF)
+      return UTF8_REPLACEMENT_CHARACTER;
+
+    return static_cast<GlyphType>(codepoint);
+  }
+}
@@ -1,8 +1,10 @@
 #include "FontCompiler.hpp"
+#include "FontAtlasTuner.hpp"
 
 #include <vector>
 #include <filesystem>
 #include <iostream>
+#include <charconv>
 #include "FontLoader.hpp"
 
 int main(int argc, char* argv[])
@@ -11,7 +13,55 @@ int main(int argc, char* argv[])
 
   std::vector<std::string> paths;
 
-  if (argc == 1)
+  // UTF-8 text files passed with --corpus. Only the codepoints used in them are compiled.
+  std::vector<dash_tools::AssetPath> corpusPaths;
+
+  // Passing --budget <bytes> tunes the atlas parameters to the smallest atlas within it that is accurate enough
+  std::optional<dash_tools::FontAtlasBudget> budget;
+  double maxError = dash_tools::FontAtlasTuner::DEFAULT_MAX_ERROR;
+
+  for (int i{ 1 }; i < argc; ++i)
+  {
+    std::string_view const ARG{ argv[i] };
+
+    if (ARG == "--corpus" && i + 1 < argc)
+      corpusPaths.emplace_back(argv[++i]);
+    else if (ARG == "--budget" && i + 1 < argc)
+    {
+      std::string_view const VALUE{ argv[++i] };
+      uint32_t maxBytes = 0;
+
+      // Rejects anything that isn't entirely a number that fits in 32 bits
+      auto const [END, ERROR_CODE] = std::from_chars(VALUE.data(), VALUE.data() + VALUE.size(), maxBytes);
+      if (ERROR_CODE != std::errc{} || END != VALUE.data() + VALUE.size())
+      {
+        std::cout << "Invalid --budget value: " << VALUE << std::endl;
+        msdfgen::deinitializeFreetype(freetypeHandle);
+        return 1;
+      }
+
+      budget = dash_tools::FontAtlasBudget{ maxBytes, maxError };
+    }
+    else if (ARG == "--max-error" && i + 1 < argc)
+    {
+      std::string_view const VALUE{ argv[++i] };
+
+      auto const [END, ERROR_CODE] = std::from_chars(VALUE.data(), VALUE.data() + VALUE.size(), maxError);
+      if (ERROR_CODE != std::errc{} || END != VALUE.data() + VALUE.size() || !(maxError >= 0.0))
+      {
+        std::cout << "Invalid --max-error value: " << VALUE << std::endl;
+        msdfgen::deinitializeFreetype(freetypeHandle);
+        return 1;
+      }
+    }
+    else
+      paths.emplace_back(argv[i]);
+  }
+
+  if (budget)
+    budget->maxError = maxError;
+
+  if (paths.empty())
   {
     if (std::filesystem::is_directory(dash_tools::ASSET_ROOT))
     {
@@ -32,17 +82,27 @@ int main(int argc, char* argv[])
       return 1;
     }
   }
-  else if (argc > 1)
+
+  if (!corpusPaths.empty())
   {
-    for (int i{ 1 }; i < argc; ++i)
+    auto corpusCharset = dash_tools::FontCompiler::LoadCorpusCharset(corpusPaths);
+    if (!corpusCharset)
     {
-      paths.emplace_back(argv[i]);
+      msdfgen::deinitializeFreetype(freetypeHandle);
+      return 1;
     }
-  }
 
-  for (auto const& path : paths)
+    for (auto const& path : paths)
+    {
+      dash_tools::FontCompiler::LoadAndCompileFontSubset(freetypeHandle, path, *corpusCharset, budget);
+    }
+  }
+  else
   {
-    dash_tools::FontCompiler::LoadAndCompileFont(freetypeHandle, path);
+    for (auto const& path : paths)
+    {
+      dash_tools::FontCompiler::LoadAndCompileFont(freetypeHandle, path, budget);
+    }
   }
 
   //SH_COMP::FontCompiler::LoadAndCompileFont(freetypeHandle, "test_font/SegoeUI.ttf");